@@ -0,0 +1,69 @@
+#include "bulk_loader.h"
+#include <iostream>
+
+BulkLoader::BulkLoader(DatabasePool& db_pool, size_t batch_size, std::chrono::milliseconds flush_interval)
+    : db_pool(db_pool), batch_size(batch_size > 0 ? batch_size : 1), flush_interval(flush_interval) {
+    buffer.reserve(this->batch_size);
+    writer = std::thread([this] { run(); });
+}
+
+BulkLoader::~BulkLoader() {
+    finish();
+}
+
+void BulkLoader::add(const std::string& url, const WordCounter& freq, const DocumentMeta& meta) {
+    bool full;
+    {
+        std::lock_guard<std::mutex> lock(buffer_mutex);
+        documents.push_back({url, meta});
+        for (const auto& entry : freq) {
+            buffer.push_back({url, std::string(entry.word), entry.count});
+        }
+        full = buffer.size() >= batch_size;
+    }
+    if (full) condition.notify_one();
+}
+
+void BulkLoader::finish() {
+    {
+        std::lock_guard<std::mutex> lock(buffer_mutex);
+        if (stop) return;
+        stop = true;
+    }
+    condition.notify_one();
+    if (writer.joinable()) writer.join();
+}
+
+void BulkLoader::run() {
+    std::vector<WordDocRow> batch;
+    std::vector<DocumentRow> batch_documents;
+    for (;;) {
+        bool stopping;
+        {
+            std::unique_lock<std::mutex> lock(buffer_mutex);
+            condition.wait_for(lock, flush_interval, [this] { return stop || buffer.size() >= batch_size; });
+            batch.swap(buffer);
+            batch_documents.swap(documents);
+            buffer.reserve(batch_size);
+            stopping = stop;
+        }
+        
+        if (!batch.empty() || !batch_documents.empty()) {
+            try {
+                db_pool.acquire()->bulk_load(batch, batch_documents);
+                written += batch.size();
+                batches++;
+            } catch (const std::exception& e) {
+                failed += batch.size();
+                std::cerr << "Bulk load error (" << batch.size() << " rows): " << e.what() << std::endl;
+            }
+            batch.clear();
+            batch_documents.clear();
+        }
+        
+        if (stopping) {
+            std::lock_guard<std::mutex> lock(buffer_mutex);
+            if (buffer.empty() && documents.empty()) return;
+        }
+    }
+}
@@ -0,0 +1,44 @@
+#ifndef BULK_LOADER_H
+#define BULK_LOADER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "db.h"
+
+// Буфер (url, word, frequency) и сведений о документах, который отдельный поток
+// сбрасывает в БД пачками через Database::bulk_load. Потоки обхода в БД не ходят.
+class BulkLoader {
+public:
+    BulkLoader(DatabasePool& db_pool, size_t batch_size, std::chrono::milliseconds flush_interval);
+    ~BulkLoader();
+    
+    void add(const std::string& url, const WordCounter& freq, const DocumentMeta& meta);
+    void finish();
+    
+    size_t rows_written() const { return written; }
+    size_t batches_written() const { return batches; }
+    size_t rows_failed() const { return failed; }
+    
+private:
+    void run();
+    
+    DatabasePool& db_pool;
+    size_t batch_size;
+    std::chrono::milliseconds flush_interval;
+    std::vector<WordDocRow> buffer;
+    std::vector<DocumentRow> documents;
+    std::mutex buffer_mutex;
+    std::condition_variable condition;
+    bool stop = false;
+    std::atomic<size_t> written{0};
+    std::atomic<size_t> batches{0};
+    std::atomic<size_t> failed{0};
+    std::thread writer;
+};
+
+#endif
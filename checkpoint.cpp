@@ -0,0 +1,186 @@
+#include "checkpoint.h"
+#include <algorithm>
+#include <filesystem>
+#include <iostream>
+#include <stdexcept>
+
+namespace {
+
+const char snapshot_magic[8] = {'C', 'R', 'A', 'W', 'L', 'C', 'P', '1'};
+const uint32_t max_url_length = 1 << 20;
+
+// Числа пишутся в little-endian независимо от платформы
+void put_u32(std::string& out, uint32_t value) {
+    for (int i = 0; i < 4; ++i) out += static_cast<char>((value >> (8 * i)) & 0xFF);
+}
+
+void put_u64(std::string& out, uint64_t value) {
+    for (int i = 0; i < 8; ++i) out += static_cast<char>((value >> (8 * i)) & 0xFF);
+}
+
+bool get_u32(std::istream& in, uint32_t& value) {
+    unsigned char bytes[4];
+    if (!in.read(reinterpret_cast<char*>(bytes), 4)) return false;
+    value = 0;
+    for (int i = 0; i < 4; ++i) value |= static_cast<uint32_t>(bytes[i]) << (8 * i);
+    return true;
+}
+
+bool get_u64(std::istream& in, uint64_t& value) {
+    unsigned char bytes[8];
+    if (!in.read(reinterpret_cast<char*>(bytes), 8)) return false;
+    value = 0;
+    for (int i = 0; i < 8; ++i) value |= static_cast<uint64_t>(bytes[i]) << (8 * i);
+    return true;
+}
+
+void put_pending(std::string& out, const std::string& url, int depth) {
+    put_u32(out, static_cast<uint32_t>(depth));
+    put_u32(out, static_cast<uint32_t>(url.size()));
+    out += url;
+}
+
+bool get_pending(std::istream& in, Checkpoint::Pending& pending) {
+    uint32_t depth, length;
+    if (!get_u32(in, depth) || !get_u32(in, length) || length > max_url_length) return false;
+    pending.depth = static_cast<int>(depth);
+    pending.url.resize(length);
+    return static_cast<bool>(in.read(&pending.url[0], length));
+}
+
+} // namespace
+
+Checkpoint::Checkpoint(const std::string& directory, UrlSet& seen, size_t snapshot_every)
+    : seen(seen), snapshot_every(snapshot_every > 0 ? snapshot_every : 1) {
+    std::filesystem::create_directories(directory);
+    snapshot_path = (std::filesystem::path(directory) / "crawl.snapshot").string();
+    log_path = (std::filesystem::path(directory) / "crawl.log").string();
+}
+
+Checkpoint::~Checkpoint() {
+    try {
+        snapshot();
+    } catch (const std::exception& e) {
+        std::cerr << "Checkpoint error: " << e.what() << std::endl;
+    }
+}
+
+std::vector<Checkpoint::Pending> Checkpoint::open(bool resume) {
+    std::lock_guard<std::mutex> lock(checkpoint_mutex);
+    if (resume) {
+        read_snapshot();
+        replay_log();
+    }
+    write_snapshot();
+    
+    std::vector<Pending> result;
+    result.reserve(pending.size());
+    for (const auto& [fp, entry] : pending) result.push_back(entry);
+    std::sort(result.begin(), result.end(), [](const Pending& a, const Pending& b) { return a.depth < b.depth; });
+    return result;
+}
+
+void Checkpoint::read_snapshot() {
+    std::ifstream in(snapshot_path, std::ios::binary);
+    if (!in) return;
+    
+    char magic[sizeof(snapshot_magic)];
+    if (!in.read(magic, sizeof(magic)) || !std::equal(magic, magic + sizeof(magic), snapshot_magic)) {
+        throw std::runtime_error("Invalid checkpoint snapshot: " + snapshot_path);
+    }
+    
+    uint64_t count;
+    if (!get_u64(in, count)) throw std::runtime_error("Truncated checkpoint snapshot");
+    for (uint64_t i = 0; i < count; ++i) {
+        uint64_t fp;
+        if (!get_u64(in, fp)) throw std::runtime_error("Truncated checkpoint snapshot");
+        seen.insert_fingerprint(fp);
+    }
+    
+    if (!get_u64(in, count)) throw std::runtime_error("Truncated checkpoint snapshot");
+    for (uint64_t i = 0; i < count; ++i) {
+        Pending entry;
+        if (!get_pending(in, entry)) throw std::runtime_error("Truncated checkpoint snapshot");
+        pending[UrlSet::fingerprint(entry.url)] = std::move(entry);
+    }
+}
+
+// Журнал читается до первой неполной записи: её мог оборвать сбой
+void Checkpoint::replay_log() {
+    std::ifstream in(log_path, std::ios::binary);
+    if (!in) return;
+    
+    size_t replayed = 0;
+    char type;
+    while (in.get(type)) {
+        if (type == 'Q') {
+            Pending entry;
+            if (!get_pending(in, entry)) break;
+            uint64_t fp = UrlSet::fingerprint(entry.url);
+            seen.insert_fingerprint(fp);
+            pending[fp] = std::move(entry);
+        } else if (type == 'D') {
+            uint64_t fp;
+            if (!get_u64(in, fp)) break;
+            pending.erase(fp);
+        } else {
+            std::cerr << "Unknown checkpoint log record, stopping replay" << std::endl;
+            break;
+        }
+        ++replayed;
+    }
+    std::cout << "Checkpoint: replayed " << replayed << " log records" << std::endl;
+}
+
+// Снимок пишется во временный файл и заменяет старый переименованием,
+// после чего журнал начинается заново
+void Checkpoint::write_snapshot() {
+    std::string data(snapshot_magic, sizeof(snapshot_magic));
+    std::vector<uint64_t> fingerprints = seen.fingerprints();
+    put_u64(data, fingerprints.size());
+    for (uint64_t fp : fingerprints) put_u64(data, fp);
+    put_u64(data, pending.size());
+    for (const auto& [fp, entry] : pending) put_pending(data, entry.url, entry.depth);
+    
+    std::string temp_path = snapshot_path + ".tmp";
+    {
+        std::ofstream out(temp_path, std::ios::binary | std::ios::trunc);
+        if (!out.write(data.data(), data.size()) || !out.flush()) {
+            throw std::runtime_error("Cannot write checkpoint snapshot: " + temp_path);
+        }
+    }
+    std::filesystem::rename(temp_path, snapshot_path);
+    
+    log.close();
+    log.open(log_path, std::ios::binary | std::ios::trunc);
+    if (!log) throw std::runtime_error("Cannot open checkpoint log: " + log_path);
+    records = 0;
+}
+
+void Checkpoint::append(const std::string& record) {
+    log.write(record.data(), record.size());
+    log.flush();
+    if (++records >= snapshot_every) write_snapshot();
+}
+
+void Checkpoint::queued(const std::string& url, int depth) {
+    std::string record(1, 'Q');
+    put_pending(record, url, depth);
+    std::lock_guard<std::mutex> lock(checkpoint_mutex);
+    pending[UrlSet::fingerprint(url)] = {url, depth};
+    append(record);
+}
+
+void Checkpoint::done(const std::string& url) {
+    uint64_t fp = UrlSet::fingerprint(url);
+    std::string record(1, 'D');
+    put_u64(record, fp);
+    std::lock_guard<std::mutex> lock(checkpoint_mutex);
+    pending.erase(fp);
+    append(record);
+}
+
+void Checkpoint::snapshot() {
+    std::lock_guard<std::mutex> lock(checkpoint_mutex);
+    write_snapshot();
+}
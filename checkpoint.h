@@ -0,0 +1,50 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "url_set.h"
+
+// Состояние обхода на диске: снимок (отпечатки просмотренных URL и очередь)
+// и журнал, в который дописываются постановки URL в очередь и завершения страниц.
+// Каждые snapshot_every записей журнал сворачивается в новый снимок.
+// При --resume снимок и журнал восстанавливают UrlSet и недообработанные URL
+class Checkpoint {
+public:
+    struct Pending {
+        std::string url;
+        int depth;
+    };
+    
+    Checkpoint(const std::string& directory, UrlSet& seen, size_t snapshot_every);
+    ~Checkpoint();
+    
+    // С resume загружает сохранённое состояние в seen и возвращает очередь,
+    // иначе стирает его. Вызывается один раз до начала обхода
+    std::vector<Pending> open(bool resume);
+    
+    void queued(const std::string& url, int depth);
+    void done(const std::string& url);
+    void snapshot();
+    
+private:
+    void read_snapshot();
+    void replay_log();
+    void write_snapshot();
+    void append(const std::string& record);
+    
+    std::string snapshot_path;
+    std::string log_path;
+    UrlSet& seen;
+    size_t snapshot_every;
+    size_t records = 0;
+    std::unordered_map<uint64_t, Pending> pending;
+    std::ofstream log;
+    std::mutex checkpoint_mutex;
+};
+
+#endif
@@ -34,6 +34,12 @@ std::map<std::string, std::string> parse_ini(const std::string& filename) {
     return config;
 }
 
+static std::string get_or(const std::map<std::string, std::string>& m, const std::string& key,
+                          const std::string& default_value) {
+    auto it = m.find(key);
+    return it != m.end() ? it->second : default_value;
+}
+
 Config::Config(const std::map<std::string, std::string>& m) {
     db_host = m.at("db_host");
     db_port = m.at("db_port");
@@ -43,4 +49,30 @@ Config::Config(const std::map<std::string, std::string>& m) {
     start_page = m.at("start_page");
     recursion_depth = std::stoi(m.at("recursion_depth"));
     server_port = m.at("server_port");
+    server_threads = std::stoi(get_or(m, "server_threads", "0"));
+    search_threads = std::stoi(get_or(m, "search_threads", "0"));
+    max_pending_searches = std::stoi(get_or(m, "max_pending_searches", "256"));
+    request_timeout_seconds = std::stoi(get_or(m, "request_timeout_seconds", "30"));
+    max_in_flight = std::stoi(get_or(m, "max_in_flight", "16"));
+    fetch_threads = std::stoi(get_or(m, "fetch_threads", "1"));
+    spider_threads = std::stoi(get_or(m, "spider_threads", "0"));
+    host_delay_ms = std::stoi(get_or(m, "host_delay_ms", "500"));
+    host_burst = std::stoi(get_or(m, "host_burst", "2"));
+    host_max_connections = std::stoi(get_or(m, "host_max_connections", "2"));
+    respect_robots = std::stoi(get_or(m, "respect_robots", "1")) != 0;
+    max_links_per_page = std::stoi(get_or(m, "max_links_per_page", "0"));
+    url_bloom_mb = std::stoi(get_or(m, "url_bloom_mb", "0"));
+    checkpoint_dir = get_or(m, "checkpoint_dir", "");
+    checkpoint_every = std::stoi(get_or(m, "checkpoint_every", "10000"));
+    dns_ttl = std::stoi(get_or(m, "dns_ttl", "300"));
+    dns_negative_ttl = std::stoi(get_or(m, "dns_negative_ttl", "30"));
+    max_page_size = std::stoul(get_or(m, "max_page_size", "10485760"));
+    db_pool_size = std::stoi(get_or(m, "db_pool_size", "4"));
+    bulk_load = std::stoi(get_or(m, "bulk_load", "0")) != 0;
+    bulk_batch_size = std::stoi(get_or(m, "bulk_batch_size", "50000"));
+    bulk_flush_interval_ms = std::stoi(get_or(m, "bulk_flush_interval_ms", "2000"));
+    word_cache = std::stoi(get_or(m, "word_cache", "1")) != 0;
+    memory_index = std::stoi(get_or(m, "memory_index", "1")) != 0;
+    index_reload_seconds = std::stoi(get_or(m, "index_reload_seconds", "300"));
+    index_segment = get_or(m, "index_segment", "");
 }
\ No newline at end of file
@@ -14,7 +14,33 @@ struct Config {
     std::string db_password;
     std::string start_page;
     int recursion_depth;
+    int max_in_flight;
+    int fetch_threads;
+    int spider_threads;
+    int host_delay_ms;
+    int host_burst;
+    int host_max_connections;
+    bool respect_robots;
+    int max_links_per_page;
+    int url_bloom_mb;
+    std::string checkpoint_dir;
+    int checkpoint_every;
+    int dns_ttl;
+    int dns_negative_ttl;
+    size_t max_page_size;
     std::string server_port;
+    int server_threads;
+    int search_threads;
+    int max_pending_searches;
+    int request_timeout_seconds;
+    int db_pool_size;
+    bool bulk_load;
+    int bulk_batch_size;
+    int bulk_flush_interval_ms;
+    bool word_cache;
+    bool memory_index;
+    int index_reload_seconds;
+    std::string index_segment;
     
     Config(const std::map<std::string, std::string>& m);
 };
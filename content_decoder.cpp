@@ -0,0 +1,187 @@
+#include "content_decoder.h"
+#include <algorithm>
+#include <cctype>
+
+static const size_t output_step = 16384;
+
+static std::string lowercase(std::string_view value) {
+    std::string result;
+    result.reserve(value.size());
+    for (unsigned char c : value) {
+        if (!std::isspace(c)) result += static_cast<char>(std::tolower(c));
+    }
+    return result;
+}
+
+ContentDecoder::ContentDecoder(std::string_view content_encoding, size_t max_size) : max_size(max_size) {
+    std::string value = lowercase(content_encoding);
+    if (value.empty() || value == "identity") {
+        type = Encoding::identity;
+    } else if (value == "gzip" || value == "x-gzip") {
+        type = Encoding::gzip;
+    } else if (value == "deflate") {
+        type = Encoding::deflate;
+#ifdef SEARCH_HAVE_BROTLI
+    } else if (value == "br") {
+        type = Encoding::brotli;
+        brotli = BrotliDecoderCreateInstance(nullptr, nullptr, nullptr);
+        if (!brotli) fail("brotli init failed");
+#endif
+    } else {
+        type = Encoding::unsupported;
+        error_message = "unsupported Content-Encoding: " + value;
+    }
+    
+    // gzip: 16 + MAX_WBITS; deflate определяется по первым двум байтам
+    if (type == Encoding::gzip) start_inflate(16 + MAX_WBITS);
+}
+
+ContentDecoder::~ContentDecoder() {
+    if (zlib_ready) inflateEnd(&zs);
+#ifdef SEARCH_HAVE_BROTLI
+    if (brotli) BrotliDecoderDestroyInstance(brotli);
+#endif
+}
+
+const char* ContentDecoder::accept_encoding() {
+#ifdef SEARCH_HAVE_BROTLI
+    return "gzip, deflate, br";
+#else
+    return "gzip, deflate";
+#endif
+}
+
+bool ContentDecoder::fail(const std::string& message) {
+    if (error_message.empty()) error_message = message;
+    return false;
+}
+
+bool ContentDecoder::start_inflate(int window_bits) {
+    if (inflateInit2(&zs, window_bits) != Z_OK) return fail("inflateInit2 failed");
+    zlib_ready = true;
+    return true;
+}
+
+// Увеличивает out под следующий кусок вывода, но не больше чем на байт сверх лимита,
+// чтобы превышение max_size было видно сразу
+size_t ContentDecoder::grow(std::string& out, size_t hint) {
+    size_t old_size = out.size();
+    size_t step = std::min(std::max(output_step, hint), max_size + 1 - std::min(old_size, max_size));
+    out.resize(old_size + step);
+    return step;
+}
+
+bool ContentDecoder::write(const char* data, size_t size, std::string& out) {
+    if (!error_message.empty()) return false;
+    if (size == 0) return true;
+    
+    switch (type) {
+    case Encoding::identity:
+        if (out.size() + size > max_size) return fail("page exceeds max_page_size");
+        out.append(data, size);
+        return true;
+    case Encoding::gzip:
+        return inflate_chunk(data, size, out);
+    case Encoding::deflate:
+        // По HTTP deflate должен идти с заголовком zlib, но многие серверы шлют сырой поток
+        if (!zlib_ready) {
+            head.append(data, size);
+            if (head.size() < 2) return true;
+            unsigned char cmf = static_cast<unsigned char>(head[0]);
+            unsigned char flg = static_cast<unsigned char>(head[1]);
+            bool zlib_header = (cmf & 0x0F) == 8 && ((cmf << 8) | flg) % 31 == 0;
+            if (!start_inflate(zlib_header ? MAX_WBITS : -MAX_WBITS)) return false;
+            std::string buffered;
+            buffered.swap(head);
+            return inflate_chunk(buffered.data(), buffered.size(), out);
+        }
+        return inflate_chunk(data, size, out);
+#ifdef SEARCH_HAVE_BROTLI
+    case Encoding::brotli:
+        return brotli_chunk(data, size, out);
+#endif
+    default:
+        return fail("unsupported Content-Encoding");
+    }
+}
+
+bool ContentDecoder::inflate_chunk(const char* data, size_t size, std::string& out) {
+    if (done) return true;
+    zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+    zs.avail_in = static_cast<uInt>(size);
+    
+    do {
+        size_t old_size = out.size();
+        size_t step = grow(out, zs.avail_in * 4);
+        zs.next_out = reinterpret_cast<Bytef*>(&out[old_size]);
+        zs.avail_out = static_cast<uInt>(step);
+        
+        int ret = inflate(&zs, Z_NO_FLUSH);
+        out.resize(old_size + step - zs.avail_out);
+        
+        if (out.size() > max_size) return fail("page exceeds max_page_size");
+        if (ret == Z_STREAM_END) {
+            // gzip может состоять из нескольких членов подряд
+            if (type == Encoding::gzip && zs.avail_in > 0) {
+                inflateReset(&zs);
+                continue;
+            }
+            done = true;
+            return true;
+        }
+        if (ret != Z_OK && ret != Z_BUF_ERROR) {
+            return fail("inflate error " + std::to_string(ret));
+        }
+        if (ret == Z_BUF_ERROR && zs.avail_in == 0) break;
+    } while (zs.avail_in > 0 || zs.avail_out == 0);
+    
+    return true;
+}
+
+#ifdef SEARCH_HAVE_BROTLI
+bool ContentDecoder::brotli_chunk(const char* data, size_t size, std::string& out) {
+    if (done) return true;
+    const uint8_t* next_in = reinterpret_cast<const uint8_t*>(data);
+    size_t avail_in = size;
+    
+    for (;;) {
+        size_t old_size = out.size();
+        size_t step = grow(out, avail_in * 4);
+        uint8_t* next_out = reinterpret_cast<uint8_t*>(&out[old_size]);
+        size_t avail_out = step;
+        
+        BrotliDecoderResult ret = BrotliDecoderDecompressStream(brotli, &avail_in, &next_in,
+                                                                &avail_out, &next_out, nullptr);
+        out.resize(old_size + step - avail_out);
+        
+        if (out.size() > max_size) return fail("page exceeds max_page_size");
+        if (ret == BROTLI_DECODER_RESULT_SUCCESS) {
+            done = true;
+            return true;
+        }
+        if (ret == BROTLI_DECODER_RESULT_ERROR) {
+            return fail(std::string("brotli error: ") +
+                        BrotliDecoderErrorString(BrotliDecoderGetErrorCode(brotli)));
+        }
+        if (ret == BROTLI_DECODER_RESULT_NEEDS_MORE_INPUT) return true;
+    }
+}
+#endif
+
+bool ContentDecoder::finish(std::string& out) {
+    if (!error_message.empty()) return false;
+    switch (type) {
+    case Encoding::identity:
+        return true;
+    case Encoding::deflate:
+        if (!zlib_ready && !head.empty()) {
+            std::string buffered;
+            buffered.swap(head);
+            if (!start_inflate(-MAX_WBITS) || !inflate_chunk(buffered.data(), buffered.size(), out)) return false;
+        }
+        [[fallthrough]];
+    default:
+        if (!done && (zlib_ready || type == Encoding::brotli)) return fail("truncated compressed body");
+        return true;
+    }
+}
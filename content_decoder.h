@@ -0,0 +1,52 @@
+#ifndef CONTENT_DECODER_H
+#define CONTENT_DECODER_H
+
+#include <string>
+#include <string_view>
+#include <zlib.h>
+#ifdef SEARCH_HAVE_BROTLI
+#include <brotli/decode.h>
+#endif
+
+// Потоковая распаковка тела ответа по Content-Encoding: куски подаются
+// по мере чтения из сокета, результат дописывается в out, размер которого
+// ограничен max_size
+class ContentDecoder {
+public:
+    enum class Encoding { identity, gzip, deflate, brotli, unsupported };
+    
+    ContentDecoder(std::string_view content_encoding, size_t max_size);
+    ~ContentDecoder();
+    ContentDecoder(const ContentDecoder&) = delete;
+    ContentDecoder& operator=(const ContentDecoder&) = delete;
+    
+    static const char* accept_encoding();
+    
+    bool write(const char* data, size_t size, std::string& out);
+    bool finish(std::string& out);
+    
+    Encoding encoding() const { return type; }
+    const std::string& error() const { return error_message; }
+    
+private:
+    bool start_inflate(int window_bits);
+    bool inflate_chunk(const char* data, size_t size, std::string& out);
+#ifdef SEARCH_HAVE_BROTLI
+    bool brotli_chunk(const char* data, size_t size, std::string& out);
+#endif
+    bool fail(const std::string& message);
+    size_t grow(std::string& out, size_t hint);
+    
+    Encoding type;
+    size_t max_size;
+    z_stream zs{};
+    bool zlib_ready = false;
+    bool done = false;
+    std::string head;
+#ifdef SEARCH_HAVE_BROTLI
+    BrotliDecoderState* brotli = nullptr;
+#endif
+    std::string error_message;
+};
+
+#endif
@@ -1,5 +1,5 @@
 #include "db.h"
-#include <sstream>
+#include <algorithm>
 #include <stdexcept>
 #include <pqxx/pqxx>
 
@@ -9,64 +9,288 @@ Database::Database(const Config& cfg) : conn(
     if (!conn.is_open()) throw std::runtime_error("DB connection failed");
 }
 
+// Частые запросы подготавливаются один раз на соединение при первом обращении:
+// в конструкторе таблиц ещё может не быть
+void Database::prepare_statements() {
+    if (prepared) return;
+    conn.prepare("get_doc", "SELECT id FROM documents WHERE url = $1");
+    conn.prepare("insert_doc", "INSERT INTO documents (url) VALUES ($1) RETURNING id");
+    conn.prepare("upsert_doc",
+        "INSERT INTO documents (url, etag, last_modified, fetched_at, content_hash) "
+        "VALUES ($1, NULLIF($2, ''), NULLIF($3, ''), now(), $4) "
+        "ON CONFLICT (url) DO UPDATE SET etag = EXCLUDED.etag, last_modified = EXCLUDED.last_modified, "
+        "fetched_at = EXCLUDED.fetched_at, content_hash = EXCLUDED.content_hash RETURNING id");
+    conn.prepare("get_word", "SELECT id FROM words WHERE word = $1");
+    conn.prepare("insert_word", "INSERT INTO words (word) VALUES ($1) RETURNING id");
+    conn.prepare("insert_words", "INSERT INTO words (word) SELECT unnest($1::text[]) ON CONFLICT (word) DO NOTHING");
+    conn.prepare("resolve_words",
+        "SELECT f.word, w.id, f.frequency "
+        "FROM unnest($1::text[], $2::int[]) AS f(word, frequency) "
+        "JOIN words w ON w.word = f.word");
+    // Строки с той же частотой не переписываются
+    conn.prepare("insert_frequency",
+        "INSERT INTO word_doc (word_id, doc_id, frequency) VALUES ($1, $2, $3) "
+        "ON CONFLICT (word_id, doc_id) DO UPDATE SET frequency = EXCLUDED.frequency "
+        "WHERE word_doc.frequency <> EXCLUDED.frequency");
+    conn.prepare("insert_word_doc",
+        "INSERT INTO word_doc (word_id, doc_id, frequency) "
+        "SELECT f.word_id, $2, f.frequency "
+        "FROM unnest($1::int[], $3::int[]) AS f(word_id, frequency) "
+        "ON CONFLICT (word_id, doc_id) DO UPDATE SET frequency = EXCLUDED.frequency "
+        "WHERE word_doc.frequency <> EXCLUDED.frequency");
+    conn.prepare("delete_stale_words", "DELETE FROM word_doc WHERE doc_id = $1 AND word_id <> ALL($2::int[])");
+    conn.prepare("search",
+        "SELECT d.url, SUM(wd.frequency) as rel "
+        "FROM documents d "
+        "JOIN word_doc wd ON d.id = wd.doc_id "
+        "JOIN words w ON w.id = wd.word_id "
+        "WHERE w.word = ANY($1::text[]) "
+        "GROUP BY d.id "
+        "HAVING COUNT(DISTINCT w.word) = $2 "
+        "ORDER BY rel DESC LIMIT 10");
+    prepared = true;
+}
+
 void Database::create_tables() {
     pqxx::work txn(conn);
     txn.exec("CREATE TABLE IF NOT EXISTS documents (id SERIAL PRIMARY KEY, url TEXT UNIQUE);");
     txn.exec("CREATE TABLE IF NOT EXISTS words (id SERIAL PRIMARY KEY, word TEXT UNIQUE);");
     txn.exec("CREATE TABLE IF NOT EXISTS word_doc (word_id INT, doc_id INT, frequency INT, PRIMARY KEY(word_id, doc_id));");
+    txn.exec("ALTER TABLE documents ADD COLUMN IF NOT EXISTS etag TEXT, "
+             "ADD COLUMN IF NOT EXISTS last_modified TEXT, "
+             "ADD COLUMN IF NOT EXISTS fetched_at TIMESTAMPTZ, "
+             "ADD COLUMN IF NOT EXISTS content_hash BIGINT;");
+    txn.exec("CREATE UNLOGGED TABLE IF NOT EXISTS staging_word_doc (url TEXT, word TEXT, frequency INT);");
+    txn.exec("CREATE UNLOGGED TABLE IF NOT EXISTS staging_documents "
+             "(url TEXT, etag TEXT, last_modified TEXT, content_hash BIGINT);");
     txn.commit();
 }
 
 int Database::get_or_insert_doc(const std::string& url) {
+    prepare_statements();
     pqxx::work txn(conn);
-    pqxx::result res = txn.exec("SELECT id FROM documents WHERE url = " + txn.quote(url));
+    pqxx::result res = txn.exec_prepared("get_doc", url);
     if (!res.empty()) return res[0][0].as<int>();
-    res = txn.exec("INSERT INTO documents (url) VALUES (" + txn.quote(url) + ") RETURNING id");
+    res = txn.exec_prepared("insert_doc", url);
     txn.commit();
     return res[0][0].as<int>();
 }
 
 int Database::get_or_insert_word(const std::string& word) {
+    int id;
+    if (word_cache && word_cache->find(word, id)) return id;
+    
+    prepare_statements();
     pqxx::work txn(conn);
-    pqxx::result res = txn.exec("SELECT id FROM words WHERE word = " + txn.quote(word));
-    if (!res.empty()) return res[0][0].as<int>();
-    res = txn.exec("INSERT INTO words (word) VALUES (" + txn.quote(word) + ") RETURNING id");
+    pqxx::result res = txn.exec_prepared("get_word", word);
+    if (res.empty()) {
+        res = txn.exec_prepared("insert_word", word);
+        txn.commit();
+    }
+    id = res[0][0].as<int>();
+    if (word_cache) word_cache->insert(word, id);
+    return id;
+}
+
+std::vector<std::pair<std::string, int>> Database::load_words() {
+    std::vector<std::pair<std::string, int>> words;
+    pqxx::work txn(conn);
+    for (auto [id, word] : txn.stream<int, std::string>("SELECT id, word FROM words")) {
+        words.emplace_back(std::move(word), id);
+    }
+    txn.commit();
+    return words;
+}
+
+std::unordered_map<std::string, DocumentMeta> Database::load_documents() {
+    std::unordered_map<std::string, DocumentMeta> documents;
+    pqxx::work txn(conn);
+    for (auto [url, etag, last_modified, content_hash] : txn.stream<std::string, std::string, std::string, int64_t>(
+             "SELECT url, COALESCE(etag, ''), COALESCE(last_modified, ''), content_hash "
+             "FROM documents WHERE content_hash IS NOT NULL")) {
+        documents.emplace(std::move(url), DocumentMeta{std::move(etag), std::move(last_modified), content_hash});
+    }
+    txn.commit();
+    return documents;
+}
+
+std::vector<std::pair<int, std::string>> Database::load_document_urls() {
+    std::vector<std::pair<int, std::string>> documents;
+    pqxx::work txn(conn);
+    for (auto [id, url] : txn.stream<int, std::string>("SELECT id, url FROM documents")) {
+        documents.emplace_back(id, std::move(url));
+    }
+    txn.commit();
+    return documents;
+}
+
+// Записи word_doc по возрастанию (word_id, doc_id) - в этом порядке их ждёт InvertedIndex::Builder
+void Database::stream_postings(const std::function<void(int word_id, int doc_id, int frequency)>& callback) {
+    pqxx::work txn(conn);
+    for (auto [word_id, doc_id, frequency] : txn.stream<int, int, int>(
+             "SELECT word_id, doc_id, frequency FROM word_doc ORDER BY word_id, doc_id")) {
+        callback(word_id, doc_id, frequency);
+    }
     txn.commit();
-    return res[0][0].as<int>();
 }
 
 void Database::insert_frequency(int word_id, int doc_id, int freq) {
+    prepare_statements();
     pqxx::work txn(conn);
-    txn.exec("INSERT INTO word_doc (word_id, doc_id, frequency) VALUES (" +
-             std::to_string(word_id) + ", " + std::to_string(doc_id) + ", " + 
-             std::to_string(freq) + ") ON CONFLICT (word_id, doc_id) DO UPDATE SET frequency = EXCLUDED.frequency");
+    txn.exec_prepared("insert_frequency", word_id, doc_id, freq);
     txn.commit();
 }
 
-std::vector<std::pair<std::string, int>> Database::search(const std::vector<std::string>& query_words) {
-    if (query_words.empty() || query_words.size() > 4) return {};
+// Индексация страницы целиком в одной транзакции. Id слов берутся из кэша,
+// промахи добираются одним INSERT/SELECT через unnest, строки word_doc пишутся
+// одним многострочным INSERT, а слова, которых на странице больше нет, удаляются
+int Database::index_document(const std::string& url, const WordCounter& freq, const DocumentMeta& meta) {
+    std::vector<int> word_ids;
+    std::vector<int> counts;
+    std::vector<const WordCounter::Entry*> missed;
+    word_ids.reserve(freq.size());
+    counts.reserve(freq.size());
+    for (const auto& entry : freq) {
+        int id;
+        if (word_cache && word_cache->find(entry.word, id)) {
+            word_ids.push_back(id);
+            counts.push_back(entry.count);
+        } else {
+            missed.push_back(&entry);
+        }
+    }
+    
+    // Сортировка задаёт параллельным транзакциям один порядок блокировки строк words
+    std::sort(missed.begin(), missed.end(), [](const auto* a, const auto* b) { return a->word < b->word; });
+    std::vector<std::string> missing;
+    std::vector<int> missing_counts;
+    missing.reserve(missed.size());
+    missing_counts.reserve(missed.size());
+    for (const auto* entry : missed) {
+        missing.emplace_back(entry->word);
+        missing_counts.push_back(entry->count);
+    }
+    
+    prepare_statements();
     pqxx::work txn(conn);
+    pqxx::result res = txn.exec_prepared("upsert_doc", url, meta.etag, meta.last_modified, meta.content_hash);
+    int doc_id = res[0][0].as<int>();
+    
+    if (!missing.empty()) {
+        txn.exec_prepared("insert_words", missing);
+        res = txn.exec_prepared("resolve_words", missing, missing_counts);
+        for (auto row : res) {
+            int id = row[1].as<int>();
+            word_ids.push_back(id);
+            counts.push_back(row[2].as<int>());
+            if (word_cache) word_cache->insert(row[0].as<std::string>(), id);
+        }
+    }
     
-    std::stringstream ss;
-    ss << "SELECT d.url, SUM(wd.frequency) as rel "
-       << "FROM documents d "
-       << "JOIN word_doc wd ON d.id = wd.doc_id "
-       << "JOIN words w ON w.id = wd.word_id "
-       << "WHERE w.word IN (";
+    txn.exec_prepared("delete_stale_words", doc_id, word_ids);
+    txn.exec_prepared("insert_word_doc", word_ids, doc_id, counts);
+    txn.commit();
+    return doc_id;
+}
+
+// Пакетная загрузка: COPY во временные нежурналируемые таблицы и перенос
+// в documents, words и word_doc запросами по множеству строк. Для документов
+// пакета удаляются строки word_doc со словами, которых на странице больше нет
+void Database::bulk_load(const std::vector<WordDocRow>& rows, const std::vector<DocumentRow>& documents) {
+    if (rows.empty() && documents.empty()) return;
+    pqxx::work txn(conn);
+    txn.exec("TRUNCATE staging_word_doc, staging_documents");
     
-    for (size_t i = 0; i < query_words.size(); ++i) {
-        if (i > 0) ss << ", ";
-        ss << txn.quote(query_words[i]);
+    auto stream = pqxx::stream_to::table(txn, {"staging_word_doc"}, {"url", "word", "frequency"});
+    for (const auto& row : rows) {
+        stream.write_values(row.url, row.word, row.frequency);
     }
+    stream.complete();
     
-    ss << ") GROUP BY d.id "
-       << "HAVING COUNT(DISTINCT w.word) = " << query_words.size()
-       << " ORDER BY rel DESC LIMIT 10;";
+    auto doc_stream = pqxx::stream_to::table(txn, {"staging_documents"}, {"url", "etag", "last_modified", "content_hash"});
+    for (const auto& doc : documents) {
+        doc_stream.write_values(doc.url, doc.meta.etag, doc.meta.last_modified, doc.meta.content_hash);
+    }
+    doc_stream.complete();
     
-    pqxx::result res = txn.exec(ss.str());
+    txn.exec("INSERT INTO documents (url, etag, last_modified, fetched_at, content_hash) "
+             "SELECT DISTINCT ON (url) url, NULLIF(etag, ''), NULLIF(last_modified, ''), now(), content_hash "
+             "FROM staging_documents "
+             "ON CONFLICT (url) DO UPDATE SET etag = EXCLUDED.etag, last_modified = EXCLUDED.last_modified, "
+             "fetched_at = EXCLUDED.fetched_at, content_hash = EXCLUDED.content_hash");
+    txn.exec("INSERT INTO words (word) SELECT DISTINCT word FROM staging_word_doc ORDER BY word "
+             "ON CONFLICT (word) DO NOTHING");
+    txn.exec("DELETE FROM word_doc wd USING documents d, staging_documents sd "
+             "WHERE wd.doc_id = d.id AND d.url = sd.url "
+             "AND NOT EXISTS (SELECT 1 FROM staging_word_doc s JOIN words w ON w.word = s.word "
+             "WHERE s.url = sd.url AND w.id = wd.word_id)");
+    txn.exec("INSERT INTO word_doc (word_id, doc_id, frequency) "
+             "SELECT w.id, d.id, MAX(s.frequency) "
+             "FROM staging_word_doc s "
+             "JOIN documents d ON d.url = s.url "
+             "JOIN words w ON w.word = s.word "
+             "GROUP BY w.id, d.id "
+             "ON CONFLICT (word_id, doc_id) DO UPDATE SET frequency = EXCLUDED.frequency "
+             "WHERE word_doc.frequency <> EXCLUDED.frequency");
+    txn.exec("TRUNCATE staging_word_doc, staging_documents");
+    txn.commit();
+}
+
+std::vector<std::pair<std::string, int>> Database::search(const std::vector<std::string>& words) {
+    // Повторы слова иначе не дали бы совпасть COUNT(DISTINCT)
+    std::vector<std::string> query_words = words;
+    std::sort(query_words.begin(), query_words.end());
+    query_words.erase(std::unique(query_words.begin(), query_words.end()), query_words.end());
+    if (query_words.empty() || query_words.size() > 4) return {};
+    prepare_statements();
+    pqxx::work txn(conn);
+    
+    pqxx::result res = txn.exec_prepared("search", query_words, static_cast<int>(query_words.size()));
     std::vector<std::pair<std::string, int>> results;
     for (auto row : res) {
         results.emplace_back(row[0].as<std::string>(), row[1].as<int>());
     }
     return results;
+}
+
+DatabasePool::DatabasePool(const Config& cfg, size_t size) : cfg(cfg), total(size > 0 ? size : 1) {
+    idle.reserve(total);
+    for (size_t i = 0; i < total; ++i) {
+        idle.push_back(std::make_unique<Database>(cfg));
+    }
+}
+
+DatabasePool::Handle DatabasePool::acquire() {
+    std::unique_ptr<Database> db;
+    {
+        std::unique_lock<std::mutex> lock(pool_mutex);
+        available.wait(lock, [this] { return !idle.empty(); });
+        db = std::move(idle.back());
+        idle.pop_back();
+    }
+    // Разорванное соединение заменяется новым при следующей выдаче
+    if (!db->is_open()) {
+        try {
+            db = std::make_unique<Database>(cfg);
+            db->set_word_cache(word_cache);
+        } catch (...) {
+            release(std::move(db));
+            throw;
+        }
+    }
+    return Handle(*this, std::move(db));
+}
+
+void DatabasePool::set_word_cache(WordCache* cache) {
+    std::lock_guard<std::mutex> lock(pool_mutex);
+    word_cache = cache;
+    for (auto& db : idle) db->set_word_cache(cache);
+}
+
+void DatabasePool::release(std::unique_ptr<Database> db) {
+    {
+        std::lock_guard<std::mutex> lock(pool_mutex);
+        idle.push_back(std::move(db));
+    }
+    available.notify_one();
 }
\ No newline at end of file
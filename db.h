@@ -2,21 +2,94 @@
 #define DB_H
 
 #include <pqxx/pqxx>
+#include <cstdint>
+#include <functional>
 #include <string>
+#include <unordered_map>
 #include <vector>
 #include <map>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
 #include "config.h"
+#include "word_cache.h"
+#include "utils.h"
+
+struct WordDocRow {
+    std::string url;
+    std::string word;
+    int frequency;
+};
+
+// Сведения о последней загрузке документа для повторного обхода
+struct DocumentMeta {
+    std::string etag;
+    std::string last_modified;
+    int64_t content_hash = 0;
+};
+
+struct DocumentRow {
+    std::string url;
+    DocumentMeta meta;
+};
 
 class Database {
 private:
     pqxx::connection conn;
+    WordCache* word_cache = nullptr;
+    bool prepared = false;
+    void prepare_statements();
 public:
     Database(const Config& cfg);
+    bool is_open() const { return conn.is_open(); }
     void create_tables();
+    void set_word_cache(WordCache* cache) { word_cache = cache; }
+    std::vector<std::pair<std::string, int>> load_words();
+    std::unordered_map<std::string, DocumentMeta> load_documents();
+    std::vector<std::pair<int, std::string>> load_document_urls();
+    void stream_postings(const std::function<void(int word_id, int doc_id, int frequency)>& callback);
     int get_or_insert_doc(const std::string& url);
     int get_or_insert_word(const std::string& word);
     void insert_frequency(int word_id, int doc_id, int freq);
+    int index_document(const std::string& url, const WordCounter& freq, const DocumentMeta& meta);
+    void bulk_load(const std::vector<WordDocRow>& rows, const std::vector<DocumentRow>& documents);
     std::vector<std::pair<std::string, int>> search(const std::vector<std::string>& words);
 };
 
+// Пул соединений: каждый поток берёт свой Database через acquire() и
+// возвращает его в пул при разрушении Handle
+class DatabasePool {
+public:
+    class Handle {
+    public:
+        Handle(DatabasePool& pool, std::unique_ptr<Database> db) : pool(&pool), db(std::move(db)) {}
+        Handle(Handle&& other) noexcept = default;
+        Handle& operator=(Handle&&) = delete;
+        ~Handle() { if (db) pool->release(std::move(db)); }
+        
+        Database* operator->() const { return db.get(); }
+        Database& operator*() const { return *db; }
+        
+    private:
+        DatabasePool* pool;
+        std::unique_ptr<Database> db;
+    };
+    
+    DatabasePool(const Config& cfg, size_t size);
+    
+    Handle acquire();
+    void set_word_cache(WordCache* cache);
+    size_t size() const { return total; }
+    
+private:
+    void release(std::unique_ptr<Database> db);
+    
+    Config cfg;
+    size_t total;
+    WordCache* word_cache = nullptr;
+    std::vector<std::unique_ptr<Database>> idle;
+    std::mutex pool_mutex;
+    std::condition_variable available;
+};
+
 #endif
\ No newline at end of file
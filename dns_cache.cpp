@@ -0,0 +1,54 @@
+#include "dns_cache.h"
+#include <boost/asio/post.hpp>
+
+namespace net = boost::asio;
+using tcp = net::ip::tcp;
+
+DnsCache::DnsCache(net::io_context& ioc, std::chrono::seconds ttl, std::chrono::seconds negative_ttl)
+    : ioc(ioc), ttl(ttl), negative_ttl(negative_ttl) {}
+
+void DnsCache::resolve(const std::string& host, const std::string& port, Handler handler) {
+    std::string key = host + ":" + port;
+    {
+        std::lock_guard<std::mutex> lock(cache_mutex);
+        Entry& entry = entries[key];
+        if (entry.resolving) {
+            shared_count++;
+            entry.waiters.push_back(std::move(handler));
+            return;
+        }
+        if (entry.expires > std::chrono::steady_clock::now()) {
+            hit_count++;
+            // Обработчик вызывается через post, как и после настоящего async_resolve
+            net::post(ioc, [handler = std::move(handler), ec = entry.error, results = entry.results] {
+                handler(ec, results);
+            });
+            return;
+        }
+        miss_count++;
+        entry.resolving = true;
+        entry.waiters.push_back(std::move(handler));
+    }
+    
+    auto resolver = std::make_shared<tcp::resolver>(ioc);
+    resolver->async_resolve(host, port,
+        [this, key, resolver](boost::system::error_code ec, Results results) {
+            complete(key, ec, results);
+        });
+}
+
+void DnsCache::complete(const std::string& key, boost::system::error_code ec, Results results) {
+    std::vector<Handler> waiters;
+    {
+        std::lock_guard<std::mutex> lock(cache_mutex);
+        Entry& entry = entries[key];
+        entry.results = results;
+        entry.error = ec;
+        entry.expires = std::chrono::steady_clock::now() + (ec ? negative_ttl : ttl);
+        entry.resolving = false;
+        waiters.swap(entry.waiters);
+    }
+    for (auto& waiter : waiters) {
+        waiter(ec, results);
+    }
+}
@@ -0,0 +1,51 @@
+#ifndef DNS_CACHE_H
+#define DNS_CACHE_H
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/ip/tcp.hpp>
+
+// Кэш DNS для Fetcher. Удачные ответы живут ttl, ошибки - negative_ttl.
+// Пока хост разрешается, остальные запросы к нему ждут тот же ответ.
+class DnsCache {
+public:
+    using Results = boost::asio::ip::tcp::resolver::results_type;
+    using Handler = std::function<void(boost::system::error_code, Results)>;
+    
+    DnsCache(boost::asio::io_context& ioc, std::chrono::seconds ttl, std::chrono::seconds negative_ttl);
+    
+    void resolve(const std::string& host, const std::string& port, Handler handler);
+    
+    size_t hits() const { return hit_count; }
+    size_t misses() const { return miss_count; }
+    size_t shared() const { return shared_count; }
+    
+private:
+    struct Entry {
+        Results results;
+        boost::system::error_code error;
+        std::chrono::steady_clock::time_point expires;
+        bool resolving = false;
+        std::vector<Handler> waiters;
+    };
+    
+    void complete(const std::string& key, boost::system::error_code ec, Results results);
+    
+    boost::asio::io_context& ioc;
+    std::chrono::seconds ttl;
+    std::chrono::seconds negative_ttl;
+    std::map<std::string, Entry> entries;
+    std::mutex cache_mutex;
+    std::atomic<size_t> hit_count{0};
+    std::atomic<size_t> miss_count{0};
+    std::atomic<size_t> shared_count{0};
+};
+
+#endif
@@ -0,0 +1,400 @@
+#include "fetcher.h"
+#include "content_decoder.h"
+#include <algorithm>
+#include <iostream>
+#include <optional>
+#include <boost/asio/connect.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/strand.hpp>
+#include <boost/beast/core.hpp>
+#include <boost/beast/http.hpp>
+#include <boost/beast/ssl.hpp>
+#include <openssl/err.h>
+
+namespace beast = boost::beast;
+namespace http = beast::http;
+namespace net = boost::asio;
+namespace ssl = net::ssl;
+using tcp = net::ip::tcp;
+
+// Сколько простаивающих соединений держать на хост и как долго
+static const size_t max_idle_per_host = 4;
+static const std::chrono::seconds idle_timeout(15);
+static const std::chrono::seconds request_timeout(10);
+static const size_t read_chunk_size = 16384;
+
+// Слоты app_data у SSL и SSL_CTX заняты asio, поэтому свои индексы ex_data
+static int fetcher_index() {
+    static int index = SSL_CTX_get_ex_new_index(0, nullptr, nullptr, nullptr, nullptr);
+    return index;
+}
+
+static int connection_index() {
+    static int index = SSL_get_ex_new_index(0, nullptr, nullptr, nullptr, nullptr);
+    return index;
+}
+
+struct Fetcher::Connection {
+    std::string key;
+    std::unique_ptr<beast::tcp_stream> plain;
+    std::unique_ptr<beast::ssl_stream<beast::tcp_stream>> secure;
+    beast::flat_buffer buffer;
+    std::chrono::steady_clock::time_point idle_since;
+    
+    beast::tcp_stream& lowest() {
+        return secure ? beast::get_lowest_layer(*secure) : *plain;
+    }
+};
+
+// Один HTTP-запрос: берёт соединение из пула или открывает новое,
+// отправляет запрос, читает ответ и возвращает соединение в пул
+class Fetcher::Exchange : public std::enable_shared_from_this<Fetcher::Exchange> {
+public:
+    Exchange(Fetcher& owner, std::string url, Callback callback, Validators validators)
+        : owner(owner), callback(std::move(callback)), validators(std::move(validators)) {
+        result.url = std::move(url);
+    }
+    
+    void start() {
+        const std::string& url = result.url;
+        size_t pos = url.find("://");
+        if (pos == std::string::npos) {
+            return fail("Invalid URL: missing protocol");
+        }
+        
+        std::string protocol = url.substr(0, pos);
+        std::string rest = url.substr(pos + 3);
+        
+        size_t path_pos = rest.find('/');
+        host = (path_pos == std::string::npos) ? rest : rest.substr(0, path_pos);
+        std::string target = (path_pos == std::string::npos) ? "/" : rest.substr(path_pos);
+        
+        tls = protocol == "https";
+        port = tls ? "443" : "80";
+        
+        size_t colon_pos = host.find(':');
+        if (colon_pos != std::string::npos) {
+            port = host.substr(colon_pos + 1);
+            host = host.substr(0, colon_pos);
+        }
+        key = protocol + "://" + host + ":" + port;
+        
+        req = http::request<http::empty_body>{http::verb::get, target, 11};
+        req.set(http::field::host, host);
+        req.set(http::field::user_agent, "Mozilla/5.0 (Windows NT 10.0; Win64; x64) AppleWebKit/537.36");
+        req.set(http::field::accept, "text/html,application/xhtml+xml,application/xml;q=0.9,*/*;q=0.8");
+        req.set(http::field::accept_encoding, ContentDecoder::accept_encoding());
+        if (!validators.etag.empty()) req.set(http::field::if_none_match, validators.etag);
+        if (!validators.last_modified.empty()) req.set(http::field::if_modified_since, validators.last_modified);
+        
+        conn = owner.take_connection(key);
+        if (conn) {
+            reused = true;
+            owner.reused++;
+            send();
+        } else {
+            open();
+        }
+    }
+    
+private:
+    template<class Op>
+    void with_stream(Op&& op) {
+        if (conn->secure) op(*conn->secure);
+        else op(*conn->plain);
+    }
+    
+    void open() {
+        reused = false;
+        conn = std::make_shared<Connection>();
+        conn->key = key;
+        auto executor = net::make_strand(owner.ioc);
+        if (tls) {
+            conn->secure = std::make_unique<beast::ssl_stream<beast::tcp_stream>>(executor, owner.ssl_ctx);
+            SSL* ssl = conn->secure->native_handle();
+            if (!SSL_set_tlsext_host_name(ssl, host.c_str())) {
+                beast::error_code ec{static_cast<int>(::ERR_get_error()), net::error::get_ssl_category()};
+                return fail("SNI", ec);
+            }
+            SSL_set_ex_data(ssl, connection_index(), conn.get());
+            owner.apply_session(ssl, key);
+        } else {
+            conn->plain = std::make_unique<beast::tcp_stream>(executor);
+        }
+        
+        auto self = shared_from_this();
+        owner.dns_cache.resolve(host, port,
+            [self](beast::error_code ec, DnsCache::Results results) {
+                self->on_resolve(ec, results);
+            });
+    }
+    
+    void on_resolve(beast::error_code ec, const DnsCache::Results& results) {
+        if (ec) return fail("resolve", ec);
+        conn->lowest().expires_after(request_timeout);
+        auto self = shared_from_this();
+        conn->lowest().async_connect(results,
+            [self](beast::error_code ec, const tcp::endpoint&) {
+                self->on_connect(ec);
+            });
+    }
+    
+    void on_connect(beast::error_code ec) {
+        if (ec) return fail("connect", ec);
+        owner.opened++;
+        if (!tls) return send();
+        
+        conn->lowest().expires_after(request_timeout);
+        auto self = shared_from_this();
+        conn->secure->async_handshake(ssl::stream_base::client,
+            [self](beast::error_code ec) {
+                self->on_handshake(ec);
+            });
+    }
+    
+    void on_handshake(beast::error_code ec) {
+        if (ec) return fail("handshake", ec);
+        if (SSL_session_reused(conn->secure->native_handle())) owner.resumed++;
+        send();
+    }
+    
+    void send() {
+        conn->lowest().expires_after(request_timeout);
+        auto self = shared_from_this();
+        with_stream([&](auto& stream) {
+            http::async_write(stream, req,
+                [self](beast::error_code ec, std::size_t) {
+                    self->on_write(ec);
+                });
+        });
+    }
+    
+    void on_write(beast::error_code ec) {
+        if (ec) return retry_or_fail("write", ec);
+        
+        // Сжатое тело не длиннее распакованного, поэтому тот же лимит годится и для него
+        parser.emplace();
+        parser->body_limit(owner.max_page_size);
+        conn->lowest().expires_after(request_timeout);
+        auto self = shared_from_this();
+        with_stream([&](auto& stream) {
+            http::async_read_header(stream, conn->buffer, *parser,
+                [self](beast::error_code ec, std::size_t) {
+                    self->on_header(ec);
+                });
+        });
+    }
+    
+    void on_header(beast::error_code ec) {
+        if (ec) return retry_or_fail("read", ec);
+        reused = false;
+        
+        auto& res = parser->get();
+        result.status = res.result_int();
+        auto etag = res[http::field::etag];
+        auto last_modified = res[http::field::last_modified];
+        result.etag.assign(etag.data(), etag.size());
+        result.last_modified.assign(last_modified.data(), last_modified.size());
+        auto encoding = res[http::field::content_encoding];
+        decoder.emplace(std::string_view(encoding.data(), encoding.size()), owner.max_page_size);
+        if (!decoder->error().empty()) return fail(decoder->error());
+        
+        if (decoder->encoding() == ContentDecoder::Encoding::identity) {
+            auto length = parser->content_length();
+            if (length) result.body.reserve(std::min<uint64_t>(*length, owner.max_page_size));
+        }
+        read_body();
+    }
+    
+    // Тело читается кусками в chunk и сразу распаковывается в result.body
+    void read_body() {
+        if (parser->is_done()) return complete();
+        
+        parser->get().body().data = chunk;
+        parser->get().body().size = sizeof(chunk);
+        conn->lowest().expires_after(request_timeout);
+        auto self = shared_from_this();
+        with_stream([&](auto& stream) {
+            http::async_read(stream, conn->buffer, *parser,
+                [self](beast::error_code ec, std::size_t) {
+                    self->on_body(ec);
+                });
+        });
+    }
+    
+    void on_body(beast::error_code ec) {
+        if (ec == http::error::need_buffer) ec = {};
+        if (ec) return fail("read", ec);
+        
+        size_t received = sizeof(chunk) - parser->get().body().size;
+        if (!decoder->write(chunk, received, result.body)) return fail(decoder->error());
+        read_body();
+    }
+    
+    void complete() {
+        if (!decoder->finish(result.body)) return fail(decoder->error());
+        
+        if (parser->get().keep_alive()) {
+            owner.release_connection(std::move(conn));
+        }
+        conn.reset();
+        finish();
+    }
+    
+    // Сервер мог закрыть простаивавшее keep-alive соединение: повторяем один раз на новом
+    void retry_or_fail(const char* what, beast::error_code ec) {
+        if (reused) {
+            conn.reset();
+            return open();
+        }
+        fail(what, ec);
+    }
+    
+    void fail(const std::string& what, beast::error_code ec = {}) {
+        result.error = ec ? what + ": " + ec.message() : what;
+        result.body.clear();
+        conn.reset();
+        finish();
+    }
+    
+    void finish() {
+        try {
+            callback(std::move(result));
+        } catch (const std::exception& e) {
+            std::cerr << "Fetch callback error: " << e.what() << std::endl;
+        }
+        owner.finished();
+    }
+    
+    Fetcher& owner;
+    FetchResult result;
+    Callback callback;
+    Validators validators;
+    std::string host;
+    std::string port;
+    std::string key;
+    bool tls = false;
+    bool reused = false;
+    std::shared_ptr<Connection> conn;
+    http::request<http::empty_body> req;
+    std::optional<http::response_parser<http::buffer_body>> parser;
+    std::optional<ContentDecoder> decoder;
+    char chunk[read_chunk_size];
+};
+
+Fetcher::Fetcher(const Config& cfg)
+    : work(net::make_work_guard(ioc)),
+      ssl_ctx(ssl::context::tls_client),
+      dns_cache(ioc, std::chrono::seconds(cfg.dns_ttl), std::chrono::seconds(cfg.dns_negative_ttl)),
+      max_in_flight(cfg.max_in_flight > 0 ? cfg.max_in_flight : 1),
+      max_page_size(cfg.max_page_size) {
+    ssl_ctx.set_default_verify_paths();
+    ssl_ctx.set_verify_mode(ssl::verify_none);
+    
+    // Сессии сохраняются вручную по ключу хоста, встроенный кэш OpenSSL не нужен
+    SSL_CTX* native = ssl_ctx.native_handle();
+    SSL_CTX_set_ex_data(native, fetcher_index(), this);
+    SSL_CTX_set_session_cache_mode(native, SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+    SSL_CTX_sess_set_new_cb(native, &Fetcher::on_new_session);
+    
+    int io_threads = cfg.fetch_threads > 0 ? cfg.fetch_threads : 1;
+    for (int i = 0; i < io_threads; ++i) {
+        threads.emplace_back([this] { ioc.run(); });
+    }
+}
+
+Fetcher::~Fetcher() {
+    stop();
+    for (auto& [key, session] : sessions) {
+        SSL_SESSION_free(session);
+    }
+}
+
+void Fetcher::stop() {
+    {
+        std::lock_guard<std::mutex> lock(fetcher_mutex);
+        idle.clear();
+        pending.clear();
+    }
+    work.reset();
+    ioc.stop();
+    for (auto& thread : threads) {
+        if (thread.joinable()) thread.join();
+    }
+    threads.clear();
+}
+
+void Fetcher::fetch(const std::string& url, Callback callback, Validators validators) {
+    {
+        std::lock_guard<std::mutex> lock(fetcher_mutex);
+        if (active >= max_in_flight) {
+            pending.push_back({url, std::move(callback), std::move(validators)});
+            return;
+        }
+        active++;
+    }
+    start({url, std::move(callback), std::move(validators)});
+}
+
+void Fetcher::start(Pending request) {
+    auto exchange = std::make_shared<Exchange>(*this, std::move(request.url), std::move(request.callback),
+                                               std::move(request.validators));
+    net::post(ioc, [exchange] { exchange->start(); });
+}
+
+void Fetcher::finished() {
+    Pending next;
+    {
+        std::lock_guard<std::mutex> lock(fetcher_mutex);
+        if (pending.empty()) {
+            active--;
+            return;
+        }
+        next = std::move(pending.front());
+        pending.pop_front();
+    }
+    start(std::move(next));
+}
+
+std::shared_ptr<Fetcher::Connection> Fetcher::take_connection(const std::string& key) {
+    std::lock_guard<std::mutex> lock(fetcher_mutex);
+    auto it = idle.find(key);
+    if (it == idle.end()) return nullptr;
+    
+    auto now = std::chrono::steady_clock::now();
+    auto& conns = it->second;
+    while (!conns.empty()) {
+        auto conn = std::move(conns.back());
+        conns.pop_back();
+        if (now - conn->idle_since < idle_timeout) return conn;
+    }
+    return nullptr;
+}
+
+void Fetcher::release_connection(std::shared_ptr<Connection> conn) {
+    conn->idle_since = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> lock(fetcher_mutex);
+    auto& conns = idle[conn->key];
+    if (conns.size() < max_idle_per_host) conns.push_back(std::move(conn));
+}
+
+void Fetcher::apply_session(SSL* ssl, const std::string& key) {
+    std::lock_guard<std::mutex> lock(fetcher_mutex);
+    auto it = sessions.find(key);
+    if (it != sessions.end()) SSL_set_session(ssl, it->second);
+}
+
+void Fetcher::store_session(const std::string& key, SSL_SESSION* session) {
+    std::lock_guard<std::mutex> lock(fetcher_mutex);
+    auto& slot = sessions[key];
+    if (slot) SSL_SESSION_free(slot);
+    slot = session;
+}
+
+int Fetcher::on_new_session(SSL* ssl, SSL_SESSION* session) {
+    auto* owner = static_cast<Fetcher*>(SSL_CTX_get_ex_data(SSL_get_SSL_CTX(ssl), fetcher_index()));
+    auto* conn = static_cast<Connection*>(SSL_get_ex_data(ssl, connection_index()));
+    if (!owner || !conn) return 0;
+    owner->store_session(conn->key, session);
+    return 1;
+}
@@ -0,0 +1,89 @@
+#ifndef FETCHER_H
+#define FETCHER_H
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/executor_work_guard.hpp>
+#include <boost/asio/ssl.hpp>
+#include "config.h"
+#include "dns_cache.h"
+
+struct FetchResult {
+    std::string url;
+    int status = 0;
+    std::string body;
+    std::string error;
+    std::string etag;
+    std::string last_modified;
+};
+
+// Валидаторы прошлой загрузки для условного запроса; ответ 304 приходит без тела
+struct Validators {
+    std::string etag;
+    std::string last_modified;
+};
+
+// Асинхронная загрузка страниц: один io_context, пул keep-alive соединений
+// на каждый хост, общий ssl::context с возобновлением TLS-сессий.
+// Одновременно выполняется не больше max_in_flight запросов, остальные ждут в очереди.
+class Fetcher {
+public:
+    using Callback = std::function<void(FetchResult)>;
+    
+    Fetcher(const Config& cfg);
+    ~Fetcher();
+    
+    void fetch(const std::string& url, Callback callback, Validators validators = {});
+    void stop();
+    
+    size_t connections_opened() const { return opened; }
+    size_t connections_reused() const { return reused; }
+    size_t tls_resumed() const { return resumed; }
+    const DnsCache& dns() const { return dns_cache; }
+    
+private:
+    struct Connection;
+    class Exchange;
+    
+    struct Pending {
+        std::string url;
+        Callback callback;
+        Validators validators;
+    };
+    
+    static int on_new_session(SSL* ssl, SSL_SESSION* session);
+    
+    void start(Pending request);
+    void finished();
+    std::shared_ptr<Connection> take_connection(const std::string& key);
+    void release_connection(std::shared_ptr<Connection> conn);
+    void apply_session(SSL* ssl, const std::string& key);
+    void store_session(const std::string& key, SSL_SESSION* session);
+    
+    boost::asio::io_context ioc;
+    boost::asio::executor_work_guard<boost::asio::io_context::executor_type> work;
+    boost::asio::ssl::context ssl_ctx;
+    DnsCache dns_cache;
+    size_t max_in_flight;
+    size_t max_page_size;
+    size_t active = 0;
+    std::deque<Pending> pending;
+    std::map<std::string, std::vector<std::shared_ptr<Connection>>> idle;
+    std::map<std::string, SSL_SESSION*> sessions;
+    std::mutex fetcher_mutex;
+    std::vector<std::thread> threads;
+    std::atomic<size_t> opened{0};
+    std::atomic<size_t> reused{0};
+    std::atomic<size_t> resumed{0};
+};
+
+#endif
@@ -0,0 +1,287 @@
+#include "frontier.h"
+#include <algorithm>
+#include <cctype>
+#include <iostream>
+#include <memory>
+
+namespace {
+
+// "https://host:port/path?q" -> ключ хоста "https://host:port" и цель "/path?q"
+bool split_url(const std::string& url, std::string& key, std::string& target) {
+    size_t scheme = url.find("://");
+    if (scheme == std::string::npos) return false;
+    size_t path = url.find_first_of("/?#", scheme + 3);
+    key = url.substr(0, path);
+    target = path == std::string::npos ? "/" : url.substr(path);
+    size_t fragment = target.find('#');
+    if (fragment != std::string::npos) target.erase(fragment);
+    if (target.empty() || target[0] != '/') target.insert(0, "/");
+    return true;
+}
+
+std::string trim(const std::string& s) {
+    size_t start = s.find_first_not_of(" \t\r");
+    if (start == std::string::npos) return "";
+    size_t end = s.find_last_not_of(" \t\r");
+    return s.substr(start, end - start + 1);
+}
+
+std::string lower(std::string s) {
+    for (char& c : s) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    return s;
+}
+
+// Сопоставление с шаблоном robots.txt: '*' - любая последовательность,
+// '$' в конце - конец пути, иначе совпадение по префиксу
+bool matches(const std::string& pattern, const std::string& target) {
+    size_t p = 0, t = 0;
+    size_t star = std::string::npos, star_t = 0;
+    while (true) {
+        if (p < pattern.size() && pattern[p] == '$' && p + 1 == pattern.size()) {
+            if (t == target.size()) return true;
+        } else if (p == pattern.size()) {
+            return true;
+        } else if (pattern[p] == '*') {
+            star = p++;
+            star_t = t;
+            continue;
+        } else if (t < target.size() && pattern[p] == target[t]) {
+            ++p;
+            ++t;
+            continue;
+        }
+        if (star == std::string::npos || star_t >= target.size()) return false;
+        p = star + 1;
+        t = ++star_t;
+    }
+}
+
+} // namespace
+
+RobotsRules RobotsRules::parse(const std::string& body) {
+    RobotsRules result;
+    bool group_applies = false;
+    bool in_agents = false;
+    
+    size_t pos = 0;
+    while (pos < body.size()) {
+        size_t end = body.find('\n', pos);
+        if (end == std::string::npos) end = body.size();
+        std::string line = body.substr(pos, end - pos);
+        pos = end + 1;
+        
+        size_t comment = line.find('#');
+        if (comment != std::string::npos) line.erase(comment);
+        size_t colon = line.find(':');
+        if (colon == std::string::npos) continue;
+        std::string key = lower(trim(line.substr(0, colon)));
+        std::string value = trim(line.substr(colon + 1));
+        
+        if (key == "user-agent") {
+            // Подряд идущие User-agent образуют одну группу
+            if (!in_agents) group_applies = false;
+            in_agents = true;
+            if (value == "*") group_applies = true;
+            continue;
+        }
+        in_agents = false;
+        if (!group_applies) continue;
+        
+        if (key == "allow" || key == "disallow") {
+            if (!value.empty()) result.rules.push_back({value, key == "allow"});
+        } else if (key == "crawl-delay") {
+            try {
+                result.crawl_delay = std::max(0.0, std::stod(value));
+            } catch (const std::exception&) {
+            }
+        }
+    }
+    return result;
+}
+
+// Побеждает самое длинное совпавшее правило, при равной длине - Allow
+bool RobotsRules::allowed(const std::string& target) const {
+    const Rule* best = nullptr;
+    for (const auto& rule : rules) {
+        if (!matches(rule.pattern, target)) continue;
+        if (!best || rule.pattern.size() > best->pattern.size() ||
+            (rule.pattern.size() == best->pattern.size() && rule.allow)) {
+            best = &rule;
+        }
+    }
+    return !best || best->allow;
+}
+
+Frontier::Frontier(const Config& cfg, Fetcher& fetcher, Scheduler& scheduler, Handler handler)
+    : fetcher(fetcher), scheduler(scheduler), handler(std::move(handler)),
+      host_interval(std::chrono::milliseconds(std::max(0, cfg.host_delay_ms))),
+      host_burst(std::max(1, cfg.host_burst)),
+      host_max_active(cfg.host_max_connections > 0 ? cfg.host_max_connections : 1),
+      respect_robots(cfg.respect_robots) {
+    dispatcher = std::thread([this] { run(); });
+}
+
+Frontier::~Frontier() {
+    stop();
+}
+
+void Frontier::stop() {
+    {
+        std::lock_guard<std::mutex> lock(frontier_mutex);
+        stopping = true;
+    }
+    changed.notify_all();
+    if (dispatcher.joinable()) dispatcher.join();
+}
+
+void Frontier::push(const std::string& url, int depth, Validators validators) {
+    std::string key, target;
+    if (!split_url(url, key, target)) {
+        std::cerr << "Invalid URL: " << url << std::endl;
+        return;
+    }
+    
+    scheduler.retain();
+    {
+        std::lock_guard<std::mutex> lock(frontier_mutex);
+        Host& host = host_map[key];
+        if (host.burst == 0) {
+            host.interval = host_interval;
+            host.burst = host_burst;
+            host.tokens = host_burst;
+            host.refilled = std::chrono::steady_clock::now();
+            if (!respect_robots) host.robots_state = RobotsState::ready;
+        }
+        host.queue.push({url, std::move(target), depth, next_seq++, std::move(validators)});
+        waiting.insert(key);
+        dirty = true;
+    }
+    changed.notify_one();
+}
+
+size_t Frontier::hosts() const {
+    std::lock_guard<std::mutex> lock(frontier_mutex);
+    return host_map.size();
+}
+
+void Frontier::refill(Host& host, std::chrono::steady_clock::time_point now) {
+    if (host.interval.count() == 0) {
+        host.tokens = host.burst;
+    } else {
+        double earned = std::chrono::duration<double>(now - host.refilled) / host.interval;
+        host.tokens = std::min(host.burst, host.tokens + earned);
+    }
+    host.refilled = now;
+}
+
+// Поток-диспетчер: выдаёт в Fetcher запросы тех хостов, у которых есть токен
+// и свободный слот, и спит до появления следующего токена или новых URL
+void Frontier::run() {
+    using clock = std::chrono::steady_clock;
+    std::unique_lock<std::mutex> lock(frontier_mutex);
+    
+    while (!stopping) {
+        dirty = false;
+        auto now = clock::now();
+        auto wake_at = clock::time_point::max();
+        std::vector<std::pair<std::string, Request>> ready;
+        std::vector<std::string> robots;
+        size_t dropped = 0;
+        
+        for (auto it = waiting.begin(); it != waiting.end();) {
+            Host& host = host_map[*it];
+            if (host.robots_state == RobotsState::unknown) {
+                host.robots_state = RobotsState::fetching;
+                robots.push_back(*it);
+            }
+            if (host.robots_state != RobotsState::ready) {
+                ++it;
+                continue;
+            }
+            
+            while (!host.queue.empty() && host.active < host_max_active) {
+                if (!host.robots.allowed(host.queue.top().target)) {
+                    host.queue.pop();
+                    ++dropped;
+                    continue;
+                }
+                refill(host, now);
+                if (host.tokens < 1) {
+                    auto missing = std::chrono::duration_cast<clock::duration>((1 - host.tokens) * host.interval);
+                    wake_at = std::min(wake_at, now + missing);
+                    break;
+                }
+                host.tokens -= 1;
+                host.active++;
+                ready.emplace_back(*it, host.queue.top());
+                host.queue.pop();
+            }
+            it = host.queue.empty() ? waiting.erase(it) : std::next(it);
+        }
+        
+        if (!ready.empty() || !robots.empty() || dropped) {
+            lock.unlock();
+            for (const auto& key : robots) {
+                fetcher.fetch(key + "/robots.txt", [this, key](FetchResult result) {
+                    on_robots(key, result);
+                });
+            }
+            for (auto& [key, request] : ready) {
+                int depth = request.depth;
+                fetcher.fetch(request.url, [this, key = key, depth](FetchResult result) {
+                    on_page(key, std::move(result), depth);
+                }, std::move(request.validators));
+            }
+            blocked += dropped;
+            for (size_t i = 0; i < dropped; ++i) scheduler.release();
+            lock.lock();
+            continue;
+        }
+        
+        if (wake_at == clock::time_point::max()) {
+            changed.wait(lock, [this] { return stopping || dirty; });
+        } else {
+            changed.wait_until(lock, wake_at, [this] { return stopping || dirty; });
+        }
+    }
+}
+
+// Ошибка или код, отличный от 200, означает отсутствие ограничений
+void Frontier::on_robots(const std::string& key, const FetchResult& result) {
+    RobotsRules rules;
+    if (result.error.empty() && result.status == 200) {
+        rules = RobotsRules::parse(result.body);
+    }
+    std::cout << "robots.txt for " << key << ": " << rules.rules.size() << " rules, crawl delay "
+              << rules.crawl_delay << " s" << std::endl;
+    {
+        std::lock_guard<std::mutex> lock(frontier_mutex);
+        Host& host = host_map[key];
+        host.robots = std::move(rules);
+        host.robots_state = RobotsState::ready;
+        if (host.robots.crawl_delay > 0) {
+            auto delay = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                std::chrono::duration<double>(host.robots.crawl_delay));
+            host.interval = std::max(host.interval, delay);
+            host.burst = 1;
+            host.tokens = std::min(host.tokens, 1.0);
+        }
+        dirty = true;
+    }
+    changed.notify_one();
+}
+
+void Frontier::on_page(const std::string& key, FetchResult result, int depth) {
+    {
+        std::lock_guard<std::mutex> lock(frontier_mutex);
+        host_map[key].active--;
+        dirty = true;
+    }
+    changed.notify_one();
+    
+    auto page = std::make_shared<FetchResult>(std::move(result));
+    scheduler.submit([this, page, depth] {
+        handler(*page, depth);
+    });
+    scheduler.release();
+}
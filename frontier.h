@@ -0,0 +1,104 @@
+#ifndef FRONTIER_H
+#define FRONTIER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <queue>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+#include "config.h"
+#include "fetcher.h"
+#include "scheduler.h"
+
+// Правила robots.txt для группы "User-agent: *". Fetcher представляется
+// браузером, поэтому именованные группы к нему не относятся
+struct RobotsRules {
+    struct Rule {
+        std::string pattern;
+        bool allow;
+    };
+    
+    std::vector<Rule> rules;
+    double crawl_delay = 0;
+    
+    static RobotsRules parse(const std::string& body);
+    bool allowed(const std::string& target) const;
+};
+
+// Очередь обхода: у каждого хоста своя очередь с приоритетом (меньшая глубина,
+// затем порядок обнаружения), токен-бакет и ограничение одновременных запросов.
+// До первого запроса к хосту загружается его robots.txt, Crawl-delay замедляет бакет.
+// Каждый URL в очереди удерживает планировщик (retain), ответ передаётся
+// обработчику задачей планировщика
+class Frontier {
+public:
+    using Handler = std::function<void(const FetchResult&, int depth)>;
+    
+    Frontier(const Config& cfg, Fetcher& fetcher, Scheduler& scheduler, Handler handler);
+    ~Frontier();
+    
+    void push(const std::string& url, int depth, Validators validators = {});
+    void stop();
+    
+    size_t hosts() const;
+    size_t robots_blocked() const { return blocked; }
+    
+private:
+    struct Request {
+        std::string url;
+        std::string target;
+        int depth;
+        uint64_t seq;
+        Validators validators;
+        
+        bool operator<(const Request& other) const {
+            if (depth != other.depth) return depth > other.depth;
+            return seq > other.seq;
+        }
+    };
+    
+    enum class RobotsState { unknown, fetching, ready };
+    
+    struct Host {
+        std::priority_queue<Request> queue;
+        RobotsState robots_state = RobotsState::unknown;
+        RobotsRules robots;
+        size_t active = 0;
+        double tokens = 0;
+        double burst = 0;
+        std::chrono::steady_clock::duration interval{};
+        std::chrono::steady_clock::time_point refilled;
+    };
+    
+    void run();
+    void on_robots(const std::string& key, const FetchResult& result);
+    void on_page(const std::string& key, FetchResult result, int depth);
+    void refill(Host& host, std::chrono::steady_clock::time_point now);
+    
+    Fetcher& fetcher;
+    Scheduler& scheduler;
+    Handler handler;
+    std::chrono::steady_clock::duration host_interval;
+    double host_burst;
+    size_t host_max_active;
+    bool respect_robots;
+    
+    mutable std::mutex frontier_mutex;
+    std::condition_variable changed;
+    std::map<std::string, Host> host_map;
+    std::set<std::string> waiting;
+    uint64_t next_seq = 0;
+    bool dirty = false;
+    bool stopping = false;
+    std::atomic<size_t> blocked{0};
+    std::thread dispatcher;
+};
+
+#endif
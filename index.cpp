@@ -0,0 +1,287 @@
+#include "index.h"
+#include <algorithm>
+#include <queue>
+#include <stdexcept>
+#include "db.h"
+
+namespace {
+
+void put_varint(std::vector<uint8_t>& out, uint32_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+inline uint32_t get_varint(const uint8_t*& p) {
+    uint32_t value = *p & 0x7F;
+    int shift = 7;
+    while (*p++ & 0x80) {
+        value |= static_cast<uint32_t>(*p & 0x7F) << shift;
+        shift += 7;
+    }
+    return value;
+}
+
+// Галоп: шаг удваивается, пока не перескочит цель, затем двоичный поиск
+template<class It, class Key>
+It gallop(It first, It last, Key key) {
+    size_t step = 1;
+    It low = first;
+    while (first != last && key(*first)) {
+        low = first;
+        if (static_cast<size_t>(last - first) <= step) {
+            first = last;
+            break;
+        }
+        first += step;
+        step *= 2;
+    }
+    return std::partition_point(low, first, key);
+}
+
+// Таблицы индекса, собранного в памяти
+struct OwnedTables {
+    std::vector<InvertedIndex::Term> terms;
+    std::vector<uint64_t> word_offsets;
+    std::string word_data;
+    std::vector<InvertedIndex::Block> blocks;
+    std::vector<uint8_t> data;
+    std::vector<uint64_t> url_offsets;
+    std::string url_data;
+};
+
+} // namespace
+
+void InvertedIndex::Builder::add_document(int doc_id, std::string url) {
+    if (doc_id < 0) throw std::runtime_error("Negative document id");
+    if (urls.size() <= static_cast<size_t>(doc_id)) urls.resize(doc_id + 1);
+    urls[doc_id] = std::move(url);
+    document_count++;
+}
+
+void InvertedIndex::Builder::add_word(int word_id, std::string word) {
+    words[word_id] = std::move(word);
+}
+
+void InvertedIndex::Builder::add_posting(int word_id, int doc_id, int frequency) {
+    if (doc_id < 0) throw std::runtime_error("Negative document id");
+    PostingList& list = lists[word_id];
+    uint32_t doc = static_cast<uint32_t>(doc_id);
+    if (list.count > 0 && doc <= list.last_doc) throw std::runtime_error("Postings must be sorted by doc_id");
+    
+    // Первый doc_id блока - разность с последним doc_id предыдущего блока
+    if (list.count % block_size == 0) {
+        list.blocks.push_back({doc, static_cast<uint32_t>(list.data.size())});
+    }
+    put_varint(list.data, doc - list.last_doc);
+    put_varint(list.data, static_cast<uint32_t>(std::max(frequency, 0)));
+    list.blocks.back().last_doc = doc;
+    list.last_doc = doc;
+    list.count++;
+}
+
+std::shared_ptr<const InvertedIndex> InvertedIndex::Builder::build() {
+    std::vector<std::pair<std::string, PostingList*>> sorted;
+    for (auto& [word_id, word] : words) {
+        auto it = lists.find(word_id);
+        if (it != lists.end()) sorted.emplace_back(std::move(word), &it->second);
+    }
+    std::sort(sorted.begin(), sorted.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+    
+    auto tables = std::make_shared<OwnedTables>();
+    auto index = std::make_shared<InvertedIndex>();
+    tables->word_offsets.push_back(0);
+    for (auto& [word, list] : sorted) {
+        tables->terms.push_back({tables->data.size(), static_cast<uint32_t>(tables->blocks.size()), list->count});
+        tables->word_data += word;
+        tables->word_offsets.push_back(tables->word_data.size());
+        tables->blocks.insert(tables->blocks.end(), list->blocks.begin(), list->blocks.end());
+        tables->data.insert(tables->data.end(), list->data.begin(), list->data.end());
+        index->posting_count += list->count;
+        *list = PostingList();
+    }
+    tables->url_offsets.push_back(0);
+    for (const auto& url : urls) {
+        tables->url_data += url;
+        tables->url_offsets.push_back(tables->url_data.size());
+    }
+    
+    index->document_count = document_count;
+    index->term_count = tables->terms.size();
+    index->term_table = tables->terms.data();
+    index->word_offsets = tables->word_offsets.data();
+    index->word_data = tables->word_data.data();
+    index->block_count = tables->blocks.size();
+    index->blocks = tables->blocks.data();
+    index->data_size = tables->data.size();
+    index->data = tables->data.data();
+    index->url_count = urls.size();
+    index->url_offsets = tables->url_offsets.data();
+    index->url_data = tables->url_data.data();
+    index->storage_size = tables->terms.size() * sizeof(Term) + tables->word_offsets.size() * sizeof(uint64_t)
+        + tables->word_data.size() + tables->blocks.size() * sizeof(Block) + tables->data.size()
+        + tables->url_offsets.size() * sizeof(uint64_t) + tables->url_data.size();
+    index->storage = std::move(tables);
+    
+    words.clear();
+    lists.clear();
+    urls.clear();
+    document_count = 0;
+    return index;
+}
+
+std::shared_ptr<const InvertedIndex> InvertedIndex::load(Database& db) {
+    Builder builder;
+    for (auto& [id, url] : db.load_document_urls()) builder.add_document(id, std::move(url));
+    for (auto& [word, id] : db.load_words()) builder.add_word(id, std::move(word));
+    db.stream_postings([&](int word_id, int doc_id, int frequency) {
+        builder.add_posting(word_id, doc_id, frequency);
+    });
+    return builder.build();
+}
+
+const InvertedIndex::Term* InvertedIndex::find(std::string_view key) const {
+    size_t low = 0, high = term_count;
+    while (low < high) {
+        size_t mid = low + (high - low) / 2;
+        std::string_view current = word(mid);
+        if (current == key) return &term_table[mid];
+        if (current < key) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return nullptr;
+}
+
+std::string_view InvertedIndex::word(size_t index) const {
+    return std::string_view(word_data + word_offsets[index], word_offsets[index + 1] - word_offsets[index]);
+}
+
+std::string_view InvertedIndex::url(uint32_t doc_id) const {
+    if (doc_id >= url_count) return {};
+    return std::string_view(url_data + url_offsets[doc_id], url_offsets[doc_id + 1] - url_offsets[doc_id]);
+}
+
+// Курсор по списку слова: текущий блок распакован в docs/freqs
+class InvertedIndex::Cursor {
+public:
+    Cursor(const InvertedIndex& index, const Term& term)
+        : count(term.count),
+          blocks(index.blocks + term.first_block),
+          block_count((term.count + block_size - 1) / block_size),
+          data(index.data + term.data_offset) {
+        decode(0);
+    }
+    
+    uint32_t length() const { return count; }
+    bool at_end() const { return end; }
+    uint32_t doc() const { return docs[pos]; }
+    uint32_t freq() const { return freqs[pos]; }
+    
+    void next() {
+        if (++pos == size) decode(block + 1);
+    }
+    
+    // Переход к первому doc_id >= target
+    void seek(uint32_t target) {
+        if (end || docs[pos] >= target) return;
+        if (blocks[block].last_doc < target) {
+            const Block* last = blocks + block_count;
+            const Block* it = gallop(blocks + block + 1, last, [target](const Block& b) { return b.last_doc < target; });
+            if (it == last) {
+                end = true;
+                return;
+            }
+            decode(it - blocks);
+        }
+        pos = gallop(docs + pos, docs + size, [target](uint32_t d) { return d < target; }) - docs;
+    }
+    
+private:
+    void decode(size_t index) {
+        if (index >= block_count) {
+            end = true;
+            return;
+        }
+        block = index;
+        pos = 0;
+        size = std::min<size_t>(block_size, count - block * block_size);
+        const uint8_t* p = data + blocks[block].offset;
+        uint32_t doc = block > 0 ? blocks[block - 1].last_doc : 0;
+        for (size_t i = 0; i < size; ++i) {
+            doc += get_varint(p);
+            docs[i] = doc;
+            freqs[i] = get_varint(p);
+        }
+    }
+    
+    uint32_t count;
+    const Block* blocks;
+    size_t block_count;
+    const uint8_t* data;
+    size_t block = 0;
+    size_t pos = 0;
+    size_t size = 0;
+    bool end = false;
+    uint32_t docs[block_size];
+    uint32_t freqs[block_size];
+};
+
+InvertedIndex::Results InvertedIndex::search(const std::vector<std::string>& query_words) const {
+    std::vector<std::string> words = query_words;
+    std::sort(words.begin(), words.end());
+    words.erase(std::unique(words.begin(), words.end()), words.end());
+    if (words.empty() || words.size() > 4) return {};
+    
+    std::vector<Cursor> cursors;
+    cursors.reserve(words.size());
+    for (const auto& word : words) {
+        const Term* term = find(word);
+        if (!term) return {};
+        cursors.emplace_back(*this, *term);
+    }
+    std::sort(cursors.begin(), cursors.end(), [](const Cursor& a, const Cursor& b) { return a.length() < b.length(); });
+    
+    // Куча из лучших 10: наверху худший из отобранных. При равной
+    // релевантности выше документ с меньшим id
+    using Hit = std::pair<int, uint32_t>;
+    auto better = [](const Hit& a, const Hit& b) { return a.first != b.first ? a.first > b.first : a.second < b.second; };
+    std::priority_queue<Hit, std::vector<Hit>, decltype(better)> top(better);
+    
+    Cursor& lead = cursors[0];
+    while (!lead.at_end()) {
+        uint32_t target = lead.doc();
+        int score = lead.freq();
+        size_t i = 1;
+        for (; i < cursors.size(); ++i) {
+            cursors[i].seek(target);
+            if (cursors[i].at_end()) break;
+            if (cursors[i].doc() != target) break;
+            score += cursors[i].freq();
+        }
+        if (i < cursors.size()) {
+            if (cursors[i].at_end()) break;
+            lead.seek(cursors[i].doc());
+            continue;
+        }
+        
+        if (top.size() < 10) {
+            top.emplace(score, target);
+        } else if (better(Hit(score, target), top.top())) {
+            top.pop();
+            top.emplace(score, target);
+        }
+        lead.next();
+    }
+    
+    Results results(top.size());
+    for (size_t i = top.size(); i-- > 0;) {
+        results[i] = {std::string(url(top.top().second)), top.top().first};
+        top.pop();
+    }
+    return results;
+}
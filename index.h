@@ -0,0 +1,110 @@
+#ifndef INDEX_H
+#define INDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+class Database;
+
+// Инвертированный индекс для searcher. Данные берутся из word_doc,
+// PostgreSQL остаётся источником истины. Список документов слова хранится
+// блоками по 128 записей: в заголовке блока последний doc_id и смещение,
+// внутри - разности doc_id и частоты в varint. Запрос из нескольких слов
+// пересекает списки от самого короткого, остальные догоняют его галопом
+// по заголовкам блоков; лучшие 10 документов отбираются кучей.
+// Все таблицы плоские, поэтому индекс может жить как в памяти процесса,
+// так и в отображённом файле сегмента (segment.h)
+class InvertedIndex {
+public:
+    using Results = std::vector<std::pair<std::string, int>>;
+    
+    struct Block {
+        uint32_t last_doc;
+        uint32_t offset;
+    };
+    
+    // Слово словаря: его блоки начинаются с first_block, данные - с data_offset
+    struct Term {
+        uint64_t data_offset;
+        uint32_t first_block;
+        uint32_t count;
+    };
+    
+    class Builder {
+    public:
+        void add_document(int doc_id, std::string url);
+        void add_word(int word_id, std::string word);
+        // Записи одного слова должны идти по возрастанию doc_id
+        void add_posting(int word_id, int doc_id, int frequency);
+        std::shared_ptr<const InvertedIndex> build();
+    
+    private:
+        struct PostingList {
+            uint32_t count = 0;
+            uint32_t last_doc = 0;
+            std::vector<Block> blocks;
+            std::vector<uint8_t> data;
+        };
+        
+        std::unordered_map<int, std::string> words;
+        std::unordered_map<int, PostingList> lists;
+        std::vector<std::string> urls;
+        size_t document_count = 0;
+    };
+    
+    static std::shared_ptr<const InvertedIndex> load(Database& db);
+    
+    // Сегмент на диске (segment.cpp): save пишет его через временный файл,
+    // open отображает файл в память без чтения целиком
+    void save(const std::string& path) const;
+    static std::shared_ptr<const InvertedIndex> open(const std::string& path);
+    
+    // Та же семантика, что у Database::search: документы со всеми словами запроса,
+    // релевантность - сумма частот, не больше 10 результатов
+    Results search(const std::vector<std::string>& words) const;
+    
+    size_t documents() const { return document_count; }
+    size_t terms() const { return term_count; }
+    size_t postings() const { return posting_count; }
+    size_t memory_usage() const { return storage_size; }
+    
+    static const size_t block_size = 128;
+    
+private:
+    class Cursor;
+    
+    const Term* find(std::string_view word) const;
+    std::string_view word(size_t index) const;
+    std::string_view url(uint32_t doc_id) const;
+    
+    // Владелец памяти, на которую указывают таблицы: векторы Builder или отображение файла
+    std::shared_ptr<const void> storage;
+    size_t storage_size = 0;
+    
+    size_t document_count = 0;
+    size_t posting_count = 0;
+    
+    // Словарь отсортирован по словам; слово i - word_data[word_offsets[i], word_offsets[i + 1])
+    size_t term_count = 0;
+    const Term* term_table = nullptr;
+    const uint64_t* word_offsets = nullptr;
+    const char* word_data = nullptr;
+    
+    size_t block_count = 0;
+    const Block* blocks = nullptr;
+    size_t data_size = 0;
+    const uint8_t* data = nullptr;
+    
+    // URL документа doc_id - url_data[url_offsets[doc_id], url_offsets[doc_id + 1])
+    size_t url_count = 0;
+    const uint64_t* url_offsets = nullptr;
+    const char* url_data = nullptr;
+};
+
+#endif
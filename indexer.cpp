@@ -0,0 +1,39 @@
+#include <chrono>
+#include <iostream>
+#include "config.h"
+#include "db.h"
+#include "index.h"
+
+// Выгружает documents / words / word_doc из PostgreSQL в файл сегмента,
+// который searcher открывает через mmap. Путь берётся из index_segment
+// или из первого аргумента
+int main(int argc, char** argv) {
+    try {
+        auto config_map = parse_ini("config.ini");
+        Config cfg(config_map);
+        std::string path = argc > 1 ? argv[1] : cfg.index_segment;
+        if (path.empty()) {
+            std::cerr << "Usage: indexer <segment file> (or set index_segment in config.ini)" << std::endl;
+            return 1;
+        }
+        
+        auto start = std::chrono::steady_clock::now();
+        Database db(cfg);
+        auto index = InvertedIndex::load(db);
+        auto loaded = std::chrono::steady_clock::now();
+        index->save(path);
+        auto saved = std::chrono::steady_clock::now();
+        
+        std::cout << "Segment " << path << ": " << index->documents() << " documents, "
+                  << index->terms() << " words, " << index->postings() << " postings, "
+                  << index->memory_usage() / (1024 * 1024) << " MB" << std::endl;
+        std::cout << "Export " << std::chrono::duration_cast<std::chrono::milliseconds>(loaded - start).count()
+                  << " ms, write " << std::chrono::duration_cast<std::chrono::milliseconds>(saved - loaded).count()
+                  << " ms" << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "Indexer error: " << e.what() << std::endl;
+        return 1;
+    }
+    
+    return 0;
+}
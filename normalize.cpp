@@ -0,0 +1,333 @@
+#include "utils.h"
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define SEARCH_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define SEARCH_TARGET_AVX2
+#else
+#define SEARCH_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace {
+
+// Класс ASCII-байта: 0 - выбрасывается, иначе - байт в нижнем регистре
+// (буквы, цифры и пробельные символы сохраняются, как в прежнем clean_text)
+struct AsciiTable {
+    unsigned char value[128];
+    
+    AsciiTable() {
+        for (int c = 0; c < 128; ++c) {
+            if (c >= 'A' && c <= 'Z') value[c] = static_cast<unsigned char>(c - 'A' + 'a');
+            else if ((c >= 'a' && c <= 'z') || (c >= '0' && c <= '9')) value[c] = static_cast<unsigned char>(c);
+            else if (c == ' ' || (c >= '\t' && c <= '\r')) value[c] = static_cast<unsigned char>(c);
+            else value[c] = 0;
+        }
+    }
+};
+
+const AsciiTable ascii_table;
+
+// Приведение к нижнему регистру для латиницы (Latin-1, Latin Extended-A),
+// греческого и кириллицы. Длина в UTF-8 при этом не растёт
+char32_t fold_case(char32_t c) {
+    if (c >= 0xC0 && c <= 0xDE && c != 0xD7) return c + 0x20;
+    if (c >= 0x100 && c <= 0x17F) {
+        if (c == 0x130) return 'i';
+        if (c == 0x178) return 0xFF;
+        if ((c >= 0x139 && c <= 0x148) || (c >= 0x179 && c <= 0x17E)) return (c & 1) ? c + 1 : c;
+        if (c == 0x131 || c == 0x138 || c == 0x149 || c == 0x17F) return c;
+        return (c & 1) ? c : c + 1;
+    }
+    if (c >= 0x391 && c <= 0x3AB && c != 0x3A2) return c + 0x20;
+    if (c == 0x386) return 0x3AC;
+    if (c >= 0x388 && c <= 0x38A) return c + 0x25;
+    if (c == 0x38C) return 0x3CC;
+    if (c == 0x38E || c == 0x38F) return c + 0x3F;
+    if (c >= 0x400 && c <= 0x40F) return c + 0x50;
+    if (c >= 0x410 && c <= 0x42F) return c + 0x20;
+    if ((c >= 0x460 && c <= 0x481) || (c >= 0x48A && c <= 0x4BF) || (c >= 0x4D0 && c <= 0x52F)) {
+        return (c & 1) ? c : c + 1;
+    }
+    if (c == 0x4C0) return 0x4CF;
+    if (c >= 0x4C1 && c <= 0x4CE) return (c & 1) ? c + 1 : c;
+    return c;
+}
+
+// Пробелы Unicode становятся ' ', знаки препинания и символы Latin-1
+// и General Punctuation выбрасываются, остальное проходит как есть
+enum class CodeClass { keep, space, drop };
+
+CodeClass classify(char32_t c) {
+    if (c == 0xA0 || (c >= 0x2000 && c <= 0x200B) || c == 0x2028 || c == 0x2029 ||
+        c == 0x202F || c == 0x205F || c == 0x3000) {
+        return CodeClass::space;
+    }
+    if ((c >= 0xA1 && c <= 0xBF) || c == 0xD7 || c == 0xF7 || (c >= 0x2010 && c <= 0x206F)) {
+        return CodeClass::drop;
+    }
+    return CodeClass::keep;
+}
+
+char* encode_utf8(char32_t c, char* out) {
+    if (c < 0x80) {
+        *out++ = static_cast<char>(c);
+    } else if (c < 0x800) {
+        *out++ = static_cast<char>(0xC0 | (c >> 6));
+        *out++ = static_cast<char>(0x80 | (c & 0x3F));
+    } else if (c < 0x10000) {
+        *out++ = static_cast<char>(0xE0 | (c >> 12));
+        *out++ = static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+        *out++ = static_cast<char>(0x80 | (c & 0x3F));
+    } else {
+        *out++ = static_cast<char>(0xF0 | (c >> 18));
+        *out++ = static_cast<char>(0x80 | ((c >> 12) & 0x3F));
+        *out++ = static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+        *out++ = static_cast<char>(0x80 | (c & 0x3F));
+    }
+    return out;
+}
+
+// Обрабатывает один символ, начинающийся в p. Некорректный UTF-8 выбрасывается по байту
+const unsigned char* normalize_char(const unsigned char* p, const unsigned char* end, char*& out) {
+    unsigned char lead = *p;
+    if (lead < 0x80) {
+        unsigned char mapped = ascii_table.value[lead];
+        if (mapped) *out++ = static_cast<char>(mapped);
+        return p + 1;
+    }
+    
+    // Быстрый путь для основной кириллицы U+0400-U+045F
+    if ((lead == 0xD0 || lead == 0xD1) && end - p >= 2 && (p[1] & 0xC0) == 0x80) {
+        unsigned char next = p[1];
+        if (lead == 0xD0 && next < 0x90) {
+            *out++ = static_cast<char>(0xD1);
+            *out++ = static_cast<char>(next + 0x10);
+            return p + 2;
+        }
+        if (lead == 0xD0 && next < 0xA0) {
+            *out++ = static_cast<char>(0xD0);
+            *out++ = static_cast<char>(next + 0x20);
+            return p + 2;
+        }
+        if (lead == 0xD0 && next < 0xB0) {
+            *out++ = static_cast<char>(0xD1);
+            *out++ = static_cast<char>(next - 0x20);
+            return p + 2;
+        }
+        if (lead == 0xD0 || next < 0xA0) {
+            *out++ = static_cast<char>(lead);
+            *out++ = static_cast<char>(next);
+            return p + 2;
+        }
+    }
+    
+    size_t length;
+    char32_t c;
+    if ((lead & 0xE0) == 0xC0) {
+        length = 2;
+        c = lead & 0x1F;
+    } else if ((lead & 0xF0) == 0xE0) {
+        length = 3;
+        c = lead & 0x0F;
+    } else if ((lead & 0xF8) == 0xF0) {
+        length = 4;
+        c = lead & 0x07;
+    } else {
+        return p + 1;
+    }
+    if (static_cast<size_t>(end - p) < length) return p + 1;
+    for (size_t i = 1; i < length; ++i) {
+        if ((p[i] & 0xC0) != 0x80) return p + 1;
+        c = (c << 6) | (p[i] & 0x3F);
+    }
+    static const char32_t min_value[] = {0, 0, 0x80, 0x800, 0x10000};
+    if (c < min_value[length] || c > 0x10FFFF || (c >= 0xD800 && c <= 0xDFFF)) return p + 1;
+    
+    switch (classify(c)) {
+    case CodeClass::space:
+        *out++ = ' ';
+        break;
+    case CodeClass::drop:
+        break;
+    case CodeClass::keep: {
+        char32_t folded = fold_case(c);
+        if (folded == c) {
+            std::memcpy(out, p, length);
+            out += length;
+        } else {
+            out = encode_utf8(folded, out);
+        }
+        break;
+    }
+    }
+    return p + length;
+}
+
+size_t normalize_scalar(const char* input, size_t size, char* output) {
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(input);
+    const unsigned char* end = p + size;
+    char* out = output;
+    while (p < end) p = normalize_char(p, end, out);
+    return out - output;
+}
+
+#ifdef SEARCH_X86
+inline unsigned count_trailing_zeros(unsigned mask) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return index;
+#else
+    return static_cast<unsigned>(__builtin_ctz(mask));
+#endif
+}
+
+// Копирует из lowered первые width байт, кроме отмеченных в drop. Выброшенных
+// байтов в блоке обычно немного, поэтому копируются отрезки между ними
+inline char* compact(const char* lowered, unsigned width, unsigned drop, char* out) {
+    unsigned start = 0;
+    while (drop) {
+        unsigned i = count_trailing_zeros(drop);
+        std::memcpy(out, lowered + start, i - start);
+        out += i - start;
+        start = i + 1;
+        drop &= drop - 1;
+    }
+    std::memcpy(out, lowered + start, width - start);
+    return out + (width - start);
+}
+
+// Блоки по 16 байт без старшего бита обрабатываются целиком: A-Z -> a-z,
+// затем остаются буквы, цифры и пробельные. Блоки с UTF-8 идут через normalize_char
+size_t normalize_sse2(const char* input, size_t size, char* output) {
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(input);
+    const unsigned char* end = p + size;
+    char* out = output;
+    
+    const __m128i upper_lo = _mm_set1_epi8('A' - 1);
+    const __m128i upper_hi = _mm_set1_epi8('Z' + 1);
+    const __m128i lower_lo = _mm_set1_epi8('a' - 1);
+    const __m128i lower_hi = _mm_set1_epi8('z' + 1);
+    const __m128i digit_lo = _mm_set1_epi8('0' - 1);
+    const __m128i digit_hi = _mm_set1_epi8('9' + 1);
+    const __m128i ctrl_lo = _mm_set1_epi8('\t' - 1);
+    const __m128i ctrl_hi = _mm_set1_epi8('\r' + 1);
+    const __m128i space = _mm_set1_epi8(' ');
+    const __m128i case_bit = _mm_set1_epi8(0x20);
+    
+    while (end - p >= 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        if (_mm_movemask_epi8(v)) {
+            const unsigned char* block_end = p + 16;
+            while (p < block_end) p = normalize_char(p, end, out);
+            continue;
+        }
+        
+        __m128i upper = _mm_and_si128(_mm_cmpgt_epi8(v, upper_lo), _mm_cmplt_epi8(v, upper_hi));
+        __m128i lowered = _mm_or_si128(v, _mm_and_si128(upper, case_bit));
+        __m128i letter = _mm_and_si128(_mm_cmpgt_epi8(lowered, lower_lo), _mm_cmplt_epi8(lowered, lower_hi));
+        __m128i digit = _mm_and_si128(_mm_cmpgt_epi8(v, digit_lo), _mm_cmplt_epi8(v, digit_hi));
+        __m128i blank = _mm_or_si128(_mm_cmpeq_epi8(v, space),
+                                     _mm_and_si128(_mm_cmpgt_epi8(v, ctrl_lo), _mm_cmplt_epi8(v, ctrl_hi)));
+        unsigned keep = static_cast<unsigned>(_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(letter, digit), blank)));
+        
+        if (keep == 0xFFFF) {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out), lowered);
+            out += 16;
+        } else {
+            alignas(16) char buffer[16];
+            _mm_store_si128(reinterpret_cast<__m128i*>(buffer), lowered);
+            out = compact(buffer, 16, ~keep & 0xFFFFu, out);
+        }
+        p += 16;
+    }
+    while (p < end) p = normalize_char(p, end, out);
+    return out - output;
+}
+
+SEARCH_TARGET_AVX2
+size_t normalize_avx2(const char* input, size_t size, char* output) {
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(input);
+    const unsigned char* end = p + size;
+    char* out = output;
+    
+    const __m256i upper_lo = _mm256_set1_epi8('A' - 1);
+    const __m256i upper_hi = _mm256_set1_epi8('Z' + 1);
+    const __m256i lower_lo = _mm256_set1_epi8('a' - 1);
+    const __m256i lower_hi = _mm256_set1_epi8('z' + 1);
+    const __m256i digit_lo = _mm256_set1_epi8('0' - 1);
+    const __m256i digit_hi = _mm256_set1_epi8('9' + 1);
+    const __m256i ctrl_lo = _mm256_set1_epi8('\t' - 1);
+    const __m256i ctrl_hi = _mm256_set1_epi8('\r' + 1);
+    const __m256i space = _mm256_set1_epi8(' ');
+    const __m256i case_bit = _mm256_set1_epi8(0x20);
+    
+    while (end - p >= 32) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        if (_mm256_movemask_epi8(v)) {
+            const unsigned char* block_end = p + 32;
+            while (p < block_end) p = normalize_char(p, end, out);
+            continue;
+        }
+        
+        __m256i upper = _mm256_and_si256(_mm256_cmpgt_epi8(v, upper_lo), _mm256_cmpgt_epi8(upper_hi, v));
+        __m256i lowered = _mm256_or_si256(v, _mm256_and_si256(upper, case_bit));
+        __m256i letter = _mm256_and_si256(_mm256_cmpgt_epi8(lowered, lower_lo), _mm256_cmpgt_epi8(lower_hi, lowered));
+        __m256i digit = _mm256_and_si256(_mm256_cmpgt_epi8(v, digit_lo), _mm256_cmpgt_epi8(digit_hi, v));
+        __m256i blank = _mm256_or_si256(_mm256_cmpeq_epi8(v, space),
+                                        _mm256_and_si256(_mm256_cmpgt_epi8(v, ctrl_lo), _mm256_cmpgt_epi8(ctrl_hi, v)));
+        unsigned keep = static_cast<unsigned>(_mm256_movemask_epi8(_mm256_or_si256(_mm256_or_si256(letter, digit), blank)));
+        
+        if (keep == 0xFFFFFFFFu) {
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), lowered);
+            out += 32;
+        } else {
+            alignas(32) char buffer[32];
+            _mm256_store_si256(reinterpret_cast<__m256i*>(buffer), lowered);
+            out = compact(buffer, 32, ~keep, out);
+        }
+        p += 32;
+    }
+    
+    size_t tail = end - p;
+    return (out - output) + normalize_sse2(reinterpret_cast<const char*>(p), tail, out);
+}
+
+bool cpu_has_avx2() {
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) return false;
+    __cpuid(info, 1);
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    if (!osxsave || (_xgetbv(0) & 0x6) != 0x6) return false;
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+#endif
+
+using Normalizer = size_t (*)(const char*, size_t, char*);
+
+Normalizer select_normalizer() {
+#ifdef SEARCH_X86
+    if (cpu_has_avx2()) return normalize_avx2;
+    return normalize_sse2;
+#else
+    return normalize_scalar;
+#endif
+}
+
+const Normalizer normalizer = select_normalizer();
+
+} // namespace
+
+size_t normalize_text(const char* input, size_t size, char* output) {
+    return normalizer(input, size, output);
+}
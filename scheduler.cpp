@@ -0,0 +1,137 @@
+#include "scheduler.h"
+#include <iostream>
+#include <stdexcept>
+
+namespace {
+
+// Воркер, на котором выполняется текущий поток
+thread_local const Scheduler* current_scheduler = nullptr;
+thread_local size_t current_worker = 0;
+
+} // namespace
+
+Scheduler::Scheduler(size_t threads) {
+    if (threads == 0) threads = 1;
+    workers.reserve(threads);
+    for (size_t i = 0; i < threads; ++i) {
+        workers.push_back(std::make_unique<Worker>());
+    }
+    for (size_t i = 0; i < threads; ++i) {
+        workers[i]->thread = std::thread([this, i] { run(i); });
+    }
+}
+
+Scheduler::~Scheduler() {
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& worker : workers) {
+        if (worker->thread.joinable()) {
+            worker->thread.join();
+        }
+    }
+}
+
+void Scheduler::push(Task task) {
+    ++outstanding;
+    if (current_scheduler == this) {
+        Worker& worker = *workers[current_worker];
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        worker.tasks.push_back(std::move(task));
+    } else {
+        std::lock_guard<std::mutex> lock(injected_mutex);
+        injected.push_back(std::move(task));
+    }
+    ++queued;
+    
+    // Мьютекс берётся только если кто-то спит: иначе пробуждение может
+    // попасть между проверкой условия и засыпанием воркера
+    if (sleeping.load() > 0) {
+        { std::lock_guard<std::mutex> lock(sleep_mutex); }
+        wake.notify_one();
+    }
+}
+
+void Scheduler::retain() {
+    ++outstanding;
+}
+
+void Scheduler::release() {
+    finish_one();
+}
+
+void Scheduler::finish_one() {
+    if (--outstanding == 0) {
+        { std::lock_guard<std::mutex> lock(idle_mutex); }
+        idle.notify_all();
+    }
+}
+
+void Scheduler::wait_idle() {
+    std::unique_lock<std::mutex> lock(idle_mutex);
+    idle.wait(lock, [this] { return outstanding.load() == 0; });
+}
+
+bool Scheduler::pop_local(Worker& worker, Task& task) {
+    std::lock_guard<std::mutex> lock(worker.mutex);
+    if (worker.tasks.empty()) return false;
+    task = std::move(worker.tasks.back());
+    worker.tasks.pop_back();
+    return true;
+}
+
+bool Scheduler::pop_injected(Task& task) {
+    std::lock_guard<std::mutex> lock(injected_mutex);
+    if (injected.empty()) return false;
+    task = std::move(injected.front());
+    injected.pop_front();
+    return true;
+}
+
+// Обход остальных воркеров начиная с соседа; у жертвы берётся самая старая задача
+bool Scheduler::steal(size_t thief, Task& task) {
+    for (size_t n = 1; n < workers.size(); ++n) {
+        Worker& victim = *workers[(thief + n) % workers.size()];
+        std::unique_lock<std::mutex> lock(victim.mutex, std::try_to_lock);
+        if (!lock.owns_lock() || victim.tasks.empty()) continue;
+        task = std::move(victim.tasks.front());
+        victim.tasks.pop_front();
+        ++stolen;
+        return true;
+    }
+    return false;
+}
+
+void Scheduler::execute(Task& task) {
+    --queued;
+    try {
+        task();
+    } catch (const std::exception& e) {
+        std::cerr << "Task error: " << e.what() << std::endl;
+    }
+    task = Task();
+    finish_one();
+}
+
+void Scheduler::run(size_t index) {
+    current_scheduler = this;
+    current_worker = index;
+    Worker& self = *workers[index];
+    
+    for (;;) {
+        Task task;
+        if (pop_local(self, task) || pop_injected(task) || steal(index, task)) {
+            execute(task);
+            continue;
+        }
+        
+        std::unique_lock<std::mutex> lock(sleep_mutex);
+        if (queued.load() > 0) continue;
+        if (stopping) return;
+        ++sleeping;
+        wake.wait(lock, [this] { return stopping || queued.load() > 0; });
+        --sleeping;
+    }
+}
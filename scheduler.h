@@ -0,0 +1,157 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Задача без аллокации: небольшие лямбды хранятся прямо в объекте,
+// крупные - в куче, как у std::function
+class Task {
+public:
+    static constexpr size_t inline_size = 64;
+    
+    Task() = default;
+    
+    template<class F, class = std::enable_if_t<!std::is_same<std::decay_t<F>, Task>::value>>
+    Task(F&& f) {
+        using Fn = std::decay_t<F>;
+        if constexpr (sizeof(Fn) <= inline_size && alignof(Fn) <= alignof(std::max_align_t) &&
+                      std::is_nothrow_move_constructible<Fn>::value) {
+            new (storage) Fn(std::forward<F>(f));
+            ops = &inline_ops<Fn>;
+        } else {
+            new (storage) Fn*(new Fn(std::forward<F>(f)));
+            ops = &heap_ops<Fn>;
+        }
+    }
+    
+    Task(Task&& other) noexcept : ops(other.ops) {
+        if (ops) {
+            ops->move(storage, other.storage);
+            other.ops = nullptr;
+        }
+    }
+    
+    Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+            reset();
+            ops = other.ops;
+            if (ops) {
+                ops->move(storage, other.storage);
+                other.ops = nullptr;
+            }
+        }
+        return *this;
+    }
+    
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+    
+    ~Task() { reset(); }
+    
+    explicit operator bool() const { return ops != nullptr; }
+    void operator()() { ops->call(storage); }
+    
+private:
+    struct Ops {
+        void (*call)(void*);
+        void (*move)(void* dst, void* src);
+        void (*destroy)(void*);
+    };
+    
+    template<class Fn>
+    static constexpr Ops inline_ops = {
+        [](void* p) { (*static_cast<Fn*>(p))(); },
+        [](void* dst, void* src) {
+            new (dst) Fn(std::move(*static_cast<Fn*>(src)));
+            static_cast<Fn*>(src)->~Fn();
+        },
+        [](void* p) { static_cast<Fn*>(p)->~Fn(); },
+    };
+    
+    template<class Fn>
+    static constexpr Ops heap_ops = {
+        [](void* p) { (**static_cast<Fn**>(p))(); },
+        [](void* dst, void* src) { new (dst) Fn*(*static_cast<Fn**>(src)); },
+        [](void* p) { delete *static_cast<Fn**>(p); },
+    };
+    
+    void reset() {
+        if (ops) {
+            ops->destroy(storage);
+            ops = nullptr;
+        }
+    }
+    
+    alignas(std::max_align_t) unsigned char storage[inline_size];
+    const Ops* ops = nullptr;
+};
+
+// Планировщик с перехватом работы: у каждого потока своя очередь, свои задачи
+// он берёт с конца (LIFO), чужие - с начала (FIFO). Задачи из потоков-воркеров
+// попадают в очередь того же воркера, из остальных потоков - в общую очередь.
+// Планировщик считает незавершённую работу: задачи и удержания через retain()/release(),
+// wait_idle() возвращается, когда счётчик доходит до нуля
+class Scheduler {
+public:
+    explicit Scheduler(size_t threads);
+    ~Scheduler();
+    
+    Scheduler(const Scheduler&) = delete;
+    Scheduler& operator=(const Scheduler&) = delete;
+    
+    template<class F>
+    void submit(F&& task) { push(Task(std::forward<F>(task))); }
+    
+    // Работа вне планировщика (например, загрузка страницы), после которой
+    // будут новые задачи. Пока она не отпущена, wait_idle() не вернётся
+    void retain();
+    void release();
+    
+    void wait_idle();
+    
+    size_t size() const { return workers.size(); }
+    size_t steals() const { return stolen; }
+    
+private:
+    struct alignas(64) Worker {
+        std::deque<Task> tasks;
+        std::mutex mutex;
+        std::thread thread;
+    };
+    
+    void push(Task task);
+    void run(size_t index);
+    bool pop_local(Worker& worker, Task& task);
+    bool pop_injected(Task& task);
+    bool steal(size_t thief, Task& task);
+    void execute(Task& task);
+    void finish_one();
+    
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::deque<Task> injected;
+    std::mutex injected_mutex;
+    
+    std::atomic<size_t> queued{0};
+    std::atomic<size_t> sleeping{0};
+    std::mutex sleep_mutex;
+    std::condition_variable wake;
+    bool stopping = false;
+    
+    std::atomic<size_t> outstanding{0};
+    std::mutex idle_mutex;
+    std::condition_variable idle;
+    
+    std::atomic<size_t> stolen{0};
+};
+
+#endif
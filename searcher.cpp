@@ -1,10 +1,21 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
 #include <iostream>
+#include <memory>
+#include <thread>
 #include <boost/beast/core.hpp>
 #include <boost/beast/http.hpp>
 #include <boost/beast/version.hpp>
+#include <boost/asio/dispatch.hpp>
 #include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/strand.hpp>
+#include <boost/asio/thread_pool.hpp>
 #include "config.h"
 #include "db.h"
+#include "index.h"
 #include "utils.h"
 
 namespace beast = boost::beast;
@@ -84,80 +95,248 @@ std::string parse_query(const std::string& body) {
     return decoded;
 }
 
-void handle_request(tcp::socket& socket, Database& db) {
-    try {
-        beast::flat_buffer buffer;
-        http::request<http::string_body> req;
-        http::read(socket, buffer, req);
-        
-        http::response<http::string_body> res{http::status::ok, req.version()};
-        res.set(http::field::server, BOOST_BEAST_VERSION_STRING);
-        res.set(http::field::content_type, "text/html; charset=utf-8");
+// Индекс в памяти подменяется целиком при перезагрузке, поэтому
+// указатель на него читается и пишется через atomic_load/atomic_store
+std::shared_ptr<const InvertedIndex> memory_index;
+
+// Готовый сегмент открывается отображением без обращения к БД,
+// иначе индекс строится из word_doc
+std::shared_ptr<const InvertedIndex> load_index(const Config& cfg, DatabasePool& db_pool) {
+    auto start = std::chrono::steady_clock::now();
+    bool from_segment = !cfg.index_segment.empty() && std::filesystem::exists(cfg.index_segment);
+    auto index = from_segment ? InvertedIndex::open(cfg.index_segment) : InvertedIndex::load(*db_pool.acquire());
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Index " << (from_segment ? "opened from " + cfg.index_segment : std::string("loaded from database"))
+              << " in " << ms << " ms: " << index->documents() << " documents, "
+              << index->terms() << " words, " << index->postings() << " postings, "
+              << index->memory_usage() / (1024 * 1024) << " MB" << std::endl;
+    return index;
+}
+
+void reload_index(const Config& cfg, DatabasePool& db_pool) {
+    for (;;) {
+        std::this_thread::sleep_for(std::chrono::seconds(cfg.index_reload_seconds));
+        try {
+            std::atomic_store(&memory_index, load_index(cfg, db_pool));
+        } catch (const std::exception& e) {
+            std::cerr << "Index reload error: " << e.what() << std::endl;
+        }
+    }
+}
+
+std::vector<std::string> query_words(const std::string& query_text) {
+    std::string cleaned = clean_text(query_text);
+    std::stringstream ss(cleaned);
+    std::vector<std::string> words;
+    std::string word;
+    
+    while (ss >> word && words.size() < 4) {
+        words.push_back(word);
+    }
+    return words;
+}
+
+std::string results_page(const std::string& query_text, const std::vector<std::pair<std::string, int>>& results) {
+    std::string body = "<!DOCTYPE html><html><head><title>Search Results</title>"
+                       "<style>body { font-family: Arial, sans-serif; margin: 40px; } "
+                       "ul { list-style: none; padding: 0; } "
+                       "li { margin: 10px 0; padding: 10px; background: #f8f9fa; border-radius: 5px; } "
+                       "a { text-decoration: none; color: #007bff; } "
+                       "a:hover { text-decoration: underline; } "
+                       ".relevance { color: #666; font-size: 14px; margin-left: 10px; }</style></head><body>";
+    body += "<h1>Search Results</h1>";
+    body += "<p>Query: <strong>" + query_text + "</strong></p>";
+    body += "<p><a href=\"/\">Back to search</a></p>";
+    body += generate_results(results);
+    body += "</body></html>";
+    return body;
+}
+
+// Поиск выполняется в отдельном пуле, чтобы потоки io_context не ждали БД.
+// Число запросов в работе и в очереди пула ограничено max_pending_searches,
+// сверх него клиент сразу получает 503
+class SearchService {
+public:
+    SearchService(const Config& cfg, DatabasePool& db_pool)
+        : db_pool(db_pool),
+          pool(cfg.search_threads > 0 ? cfg.search_threads : std::max(1u, std::thread::hardware_concurrency())),
+          max_pending(cfg.max_pending_searches > 0 ? cfg.max_pending_searches : 1) {}
+    
+    ~SearchService() { pool.join(); }
+    
+    // done вызывается в потоке пула с результатами или с текстом ошибки
+    template<class Handler>
+    bool submit(std::vector<std::string> words, Handler done) {
+        if (pending.fetch_add(1) >= max_pending) {
+            pending--;
+            return false;
+        }
+        net::post(pool, [this, words = std::move(words), done = std::move(done)]() mutable {
+            std::vector<std::pair<std::string, int>> results;
+            std::string error;
+            try {
+                auto index = std::atomic_load(&memory_index);
+                results = index ? index->search(words) : db_pool.acquire()->search(words);
+            } catch (const std::exception& e) {
+                error = e.what();
+            }
+            pending--;
+            done(std::move(results), std::move(error));
+        });
+        return true;
+    }
+    
+private:
+    DatabasePool& db_pool;
+    net::thread_pool pool;
+    size_t max_pending;
+    std::atomic<size_t> pending{0};
+};
+
+// Соединение с клиентом: запросы читаются по одному, следующий - после
+// отправки ответа, поэтому конвейерные запросы обслуживаются по порядку
+// (непрочитанные байты остаются в buffer). Все обработчики идут через strand сокета
+class Session : public std::enable_shared_from_this<Session> {
+public:
+    Session(tcp::socket&& socket, SearchService& search, std::chrono::seconds timeout)
+        : stream(std::move(socket)), search(search), timeout(timeout) {}
+    
+    void run() {
+        net::dispatch(stream.get_executor(), beast::bind_front_handler(&Session::do_read, shared_from_this()));
+    }
+    
+private:
+    void do_read() {
+        req = {};
+        stream.expires_after(timeout);
+        http::async_read(stream, buffer, req, beast::bind_front_handler(&Session::on_read, shared_from_this()));
+    }
+    
+    void on_read(beast::error_code ec, size_t) {
+        if (ec == http::error::end_of_stream) return close();
+        if (ec) {
+            if (ec != beast::error::timeout && ec != net::error::operation_aborted) {
+                std::cerr << "Request read error: " << ec.message() << std::endl;
+            }
+            return;
+        }
         
         if (req.method() == http::verb::get) {
-            res.body() = search_form;
+            send(http::status::ok, search_form);
         } else if (req.method() == http::verb::post) {
             std::string query_text = parse_query(req.body());
             std::cout << "Search query: " << query_text << std::endl;
             
-            std::string cleaned = clean_text(query_text);
-            std::stringstream ss(cleaned);
-            std::vector<std::string> words;
-            std::string word;
-            
-            while (ss >> word && words.size() < 4) {
-                words.push_back(word);
+            auto self = shared_from_this();
+            bool accepted = search.submit(query_words(query_text),
+                [self, query_text](std::vector<std::pair<std::string, int>> results, std::string error) {
+                    net::post(self->stream.get_executor(), [self, query_text, results = std::move(results), error = std::move(error)] {
+                        if (!error.empty()) {
+                            std::cerr << "Search error: " << error << std::endl;
+                            self->send(http::status::internal_server_error,
+                                       "<!DOCTYPE html><html><body><h1>500 Internal Server Error</h1></body></html>");
+                        } else {
+                            self->send(http::status::ok, results_page(query_text, results));
+                        }
+                    });
+                });
+            if (!accepted) {
+                send(http::status::service_unavailable,
+                     "<!DOCTYPE html><html><body><h1>503 Service Unavailable</h1><p>Server is busy, try again later.</p></body></html>");
             }
-            
-            auto results = db.search(words);
-            res.body() = "<!DOCTYPE html><html><head><title>Search Results</title>"
-                        "<style>body { font-family: Arial, sans-serif; margin: 40px; } "
-                        "ul { list-style: none; padding: 0; } "
-                        "li { margin: 10px 0; padding: 10px; background: #f8f9fa; border-radius: 5px; } "
-                        "a { text-decoration: none; color: #007bff; } "
-                        "a:hover { text-decoration: underline; } "
-                        ".relevance { color: #666; font-size: 14px; margin-left: 10px; }</style></head><body>";
-            res.body() += "<h1>Search Results</h1>";
-            res.body() += "<p>Query: <strong>" + query_text + "</strong></p>";
-            res.body() += "<p><a href=\"/\">Back to search</a></p>";
-            res.body() += generate_results(results);
-            res.body() += "</body></html>";
         } else {
-            res.result(http::status::bad_request);
-            res.body() = "<!DOCTYPE html><html><body><h1>400 Bad Request</h1><p>Invalid HTTP method.</p></body></html>";
+            send(http::status::bad_request,
+                 "<!DOCTYPE html><html><body><h1>400 Bad Request</h1><p>Invalid HTTP method.</p></body></html>");
         }
+    }
+    
+    void send(http::status status, std::string body) {
+        auto res = std::make_shared<http::response<http::string_body>>(status, req.version());
+        res->set(http::field::server, BOOST_BEAST_VERSION_STRING);
+        res->set(http::field::content_type, "text/html; charset=utf-8");
+        res->keep_alive(req.keep_alive());
+        res->body() = std::move(body);
+        res->prepare_payload();
         
-        res.prepare_payload();
-        http::write(socket, res);
-        
-        socket.shutdown(tcp::socket::shutdown_send);
-        
-    } catch (const std::exception& e) {
-        std::cerr << "Request handling error: " << e.what() << std::endl;
+        stream.expires_after(timeout);
+        http::async_write(stream, *res, [self = shared_from_this(), res](beast::error_code ec, size_t) {
+            if (ec) {
+                std::cerr << "Response write error: " << ec.message() << std::endl;
+                return;
+            }
+            if (res->need_eof()) return self->close();
+            self->do_read();
+        });
     }
-}
+    
+    void close() {
+        beast::error_code ec;
+        stream.socket().shutdown(tcp::socket::shutdown_send, ec);
+    }
+    
+    beast::tcp_stream stream;
+    beast::flat_buffer buffer;
+    http::request<http::string_body> req;
+    SearchService& search;
+    std::chrono::seconds timeout;
+};
+
+class Listener : public std::enable_shared_from_this<Listener> {
+public:
+    Listener(net::io_context& ioc, tcp::endpoint endpoint, SearchService& search, std::chrono::seconds timeout)
+        : ioc(ioc), acceptor(ioc, endpoint), search(search), timeout(timeout) {}
+    
+    void run() {
+        // У каждого соединения свой strand, соединения обслуживаются всеми потоками
+        acceptor.async_accept(net::make_strand(ioc), beast::bind_front_handler(&Listener::on_accept, shared_from_this()));
+    }
+    
+private:
+    void on_accept(beast::error_code ec, tcp::socket socket) {
+        if (ec) {
+            std::cerr << "Accept error: " << ec.message() << std::endl;
+        } else {
+            std::make_shared<Session>(std::move(socket), search, timeout)->run();
+        }
+        run();
+    }
+    
+    net::io_context& ioc;
+    tcp::acceptor acceptor;
+    SearchService& search;
+    std::chrono::seconds timeout;
+};
 
 int main(int argc, char** argv) {
     try {
         auto config_map = parse_ini("config.ini");
         Config cfg(config_map);
-        Database db(cfg);
+        DatabasePool db_pool(cfg, cfg.db_pool_size);
+        
+        if (cfg.memory_index) {
+            std::atomic_store(&memory_index, load_index(cfg, db_pool));
+            if (cfg.index_reload_seconds > 0) {
+                std::thread(reload_index, std::cref(cfg), std::ref(db_pool)).detach();
+            }
+        }
         
-        net::io_context ioc;
-        tcp::acceptor acceptor(ioc, {tcp::v4(), static_cast<unsigned short>(std::stoi(cfg.server_port))});
+        unsigned threads = cfg.server_threads > 0 ? cfg.server_threads : std::max(1u, std::thread::hardware_concurrency());
+        net::io_context ioc(static_cast<int>(threads));
+        SearchService search(cfg, db_pool);
+        tcp::endpoint endpoint(tcp::v4(), static_cast<unsigned short>(std::stoi(cfg.server_port)));
+        std::make_shared<Listener>(ioc, endpoint, search, std::chrono::seconds(cfg.request_timeout_seconds))->run();
         
-        std::cout << "Search server started on port " << cfg.server_port << std::endl;
+        std::cout << "Search server started on port " << cfg.server_port << " with " << threads << " threads" << std::endl;
         std::cout << "Open browser and navigate to: http://localhost:" << cfg.server_port << std::endl;
         
-        for (;;) {
-            tcp::socket socket(ioc);
-            acceptor.accept(socket);
-            handle_request(socket, db);
-        }
+        std::vector<std::thread> workers;
+        for (unsigned i = 1; i < threads; ++i) workers.emplace_back([&ioc] { ioc.run(); });
+        ioc.run();
+        for (auto& worker : workers) worker.join();
     } catch (const std::exception& e) {
         std::cerr << "Server error: " << e.what() << std::endl;
         return 1;
     }
     
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,232 @@
+#include "segment.h"
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include "index.h"
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(const std::string& path) {
+    // FILE_SHARE_DELETE позволяет indexer заменить файл, пока searcher держит старый
+    HANDLE handle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr,
+                                OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (handle == INVALID_HANDLE_VALUE) throw std::runtime_error("Cannot open file: " + path);
+    file = handle;
+    
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(handle, &file_size) || file_size.QuadPart == 0) {
+        CloseHandle(handle);
+        throw std::runtime_error("Cannot map empty file: " + path);
+    }
+    length = static_cast<size_t>(file_size.QuadPart);
+    
+    mapping = CreateFileMappingA(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping) {
+        CloseHandle(handle);
+        throw std::runtime_error("Cannot map file: " + path);
+    }
+    address = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    if (!address) {
+        CloseHandle(mapping);
+        CloseHandle(handle);
+        throw std::runtime_error("Cannot map file: " + path);
+    }
+}
+
+MappedFile::~MappedFile() {
+    UnmapViewOfFile(address);
+    CloseHandle(mapping);
+    CloseHandle(file);
+}
+
+#else
+
+MappedFile::MappedFile(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) throw std::runtime_error("Cannot open file: " + path);
+    
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        ::close(fd);
+        throw std::runtime_error("Cannot map empty file: " + path);
+    }
+    length = static_cast<size_t>(st.st_size);
+    
+    // Отображение остаётся действительным после закрытия дескриптора
+    void* result = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (result == MAP_FAILED) throw std::runtime_error("Cannot map file: " + path);
+    address = static_cast<const char*>(result);
+}
+
+MappedFile::~MappedFile() {
+    munmap(const_cast<char*>(address), length);
+}
+
+#endif
+
+namespace {
+
+// Формат сегмента: заголовок, затем семь таблиц индекса, каждая выровнена на 8 байт.
+// Числа хранятся в little-endian, таблицы отображаются в InvertedIndex как есть
+const char segment_magic[8] = {'I', 'D', 'X', 'S', 'E', 'G', '0', '1'};
+
+// Имена с суффиксом, чтобы не пересекаться с полями InvertedIndex
+enum Section { terms_section, word_offsets_section, word_data_section, blocks_section, data_section,
+               url_offsets_section, url_data_section, section_count };
+
+struct SectionEntry {
+    uint64_t offset;
+    uint64_t size;
+};
+
+struct SegmentHeader {
+    char magic[8];
+    uint64_t document_count;
+    uint64_t posting_count;
+    uint64_t term_count;
+    uint64_t block_count;
+    uint64_t url_count;
+    SectionEntry sections[section_count];
+};
+
+static_assert(sizeof(InvertedIndex::Term) == 16, "Term layout is part of the segment format");
+static_assert(sizeof(InvertedIndex::Block) == 8, "Block layout is part of the segment format");
+
+bool little_endian() {
+    uint16_t value = 1;
+    unsigned char first;
+    std::memcpy(&first, &value, 1);
+    return first == 1;
+}
+
+uint64_t align8(uint64_t value) {
+    return (value + 7) & ~uint64_t(7);
+}
+
+} // namespace
+
+void InvertedIndex::save(const std::string& path) const {
+    if (!little_endian()) throw std::runtime_error("Index segments require a little-endian host");
+    
+    struct Part {
+        const void* data;
+        uint64_t size;
+    };
+    const Part parts[section_count] = {
+        {term_table, term_count * sizeof(Term)},
+        {word_offsets, (term_count + 1) * sizeof(uint64_t)},
+        {word_data, word_offsets[term_count]},
+        {blocks, block_count * sizeof(Block)},
+        {data, data_size},
+        {url_offsets, (url_count + 1) * sizeof(uint64_t)},
+        {url_data, url_offsets[url_count]},
+    };
+    
+    SegmentHeader header{};
+    std::memcpy(header.magic, segment_magic, sizeof(segment_magic));
+    header.document_count = document_count;
+    header.posting_count = posting_count;
+    header.term_count = term_count;
+    header.block_count = block_count;
+    header.url_count = url_count;
+    uint64_t offset = align8(sizeof(header));
+    for (int i = 0; i < section_count; ++i) {
+        header.sections[i] = {offset, parts[i].size};
+        offset = align8(offset + parts[i].size);
+    }
+    
+    std::string temp_path = path + ".tmp";
+    {
+        std::ofstream out(temp_path, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        uint64_t position = sizeof(header);
+        const char padding[8] = {};
+        for (int i = 0; i < section_count; ++i) {
+            out.write(padding, header.sections[i].offset - position);
+            out.write(static_cast<const char*>(parts[i].data), parts[i].size);
+            position = header.sections[i].offset + parts[i].size;
+        }
+        if (!out.flush()) throw std::runtime_error("Cannot write index segment: " + temp_path);
+    }
+    std::filesystem::rename(temp_path, path);
+}
+
+// Проверяются границы таблиц и словаря; содержимое списков не читается,
+// чтобы открытие не затрагивало страницы с данными
+std::shared_ptr<const InvertedIndex> InvertedIndex::open(const std::string& path) {
+    if (!little_endian()) throw std::runtime_error("Index segments require a little-endian host");
+    
+    auto file = std::make_shared<MappedFile>(path);
+    SegmentHeader header;
+    if (file->size() < sizeof(header)) throw std::runtime_error("Truncated index segment: " + path);
+    std::memcpy(&header, file->data(), sizeof(header));
+    if (std::memcmp(header.magic, segment_magic, sizeof(segment_magic)) != 0) {
+        throw std::runtime_error("Invalid index segment: " + path);
+    }
+    if (header.term_count > file->size() || header.block_count > file->size() || header.url_count > file->size()) {
+        throw std::runtime_error("Corrupted index segment: " + path);
+    }
+    
+    auto section = [&](Section s, uint64_t expected_size) {
+        const SectionEntry& entry = header.sections[s];
+        if (entry.offset % 8 != 0 || entry.offset > file->size() || entry.size > file->size() - entry.offset
+            || (expected_size != UINT64_MAX && entry.size != expected_size)) {
+            throw std::runtime_error("Corrupted index segment: " + path);
+        }
+        return file->data() + entry.offset;
+    };
+    
+    auto index = std::make_shared<InvertedIndex>();
+    index->document_count = header.document_count;
+    index->posting_count = header.posting_count;
+    index->term_count = header.term_count;
+    index->term_table = reinterpret_cast<const Term*>(section(terms_section, header.term_count * sizeof(Term)));
+    index->word_offsets = reinterpret_cast<const uint64_t*>(section(word_offsets_section, (header.term_count + 1) * sizeof(uint64_t)));
+    index->word_data = section(word_data_section, UINT64_MAX);
+    index->block_count = header.block_count;
+    index->blocks = reinterpret_cast<const Block*>(section(blocks_section, header.block_count * sizeof(Block)));
+    index->data_size = header.sections[data_section].size;
+    index->data = reinterpret_cast<const uint8_t*>(section(data_section, UINT64_MAX));
+    index->url_count = header.url_count;
+    index->url_offsets = reinterpret_cast<const uint64_t*>(section(url_offsets_section, (header.url_count + 1) * sizeof(uint64_t)));
+    index->url_data = section(url_data_section, UINT64_MAX);
+    
+    auto check_offsets = [&](const uint64_t* offsets, size_t count, uint64_t total) {
+        if (offsets[0] != 0 || offsets[count] != total) throw std::runtime_error("Corrupted index segment: " + path);
+        for (size_t i = 0; i < count; ++i) {
+            if (offsets[i] > offsets[i + 1]) throw std::runtime_error("Corrupted index segment: " + path);
+        }
+    };
+    check_offsets(index->word_offsets, index->term_count, header.sections[word_data_section].size);
+    check_offsets(index->url_offsets, index->url_count, header.sections[url_data_section].size);
+    for (size_t i = 0; i < index->term_count; ++i) {
+        const Term& term = index->term_table[i];
+        uint64_t term_blocks = (uint64_t(term.count) + block_size - 1) / block_size;
+        if (term.first_block + term_blocks > index->block_count || term.data_offset > index->data_size) {
+            throw std::runtime_error("Corrupted index segment: " + path);
+        }
+    }
+    
+    index->storage_size = file->size();
+    index->storage = std::move(file);
+    return index;
+}
@@ -0,0 +1,29 @@
+#ifndef SEGMENT_H
+#define SEGMENT_H
+
+#include <cstddef>
+#include <string>
+
+// Файл, отображённый в память только для чтения. Страницы подгружаются
+// при первом обращении и делятся между процессами, открывшими тот же файл
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path);
+    ~MappedFile();
+    
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    
+    const char* data() const { return address; }
+    size_t size() const { return length; }
+    
+private:
+    const char* address = nullptr;
+    size_t length = 0;
+#ifdef _WIN32
+    void* file = nullptr;
+    void* mapping = nullptr;
+#endif
+};
+
+#endif
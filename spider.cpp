@@ -1,124 +1,23 @@
 #include <iostream>
 #include <set>
-#include <mutex>
-#include <condition_variable>
-#include <queue>
 #include <vector>
 #include <functional>
 #include <thread>
 #include <chrono>
 #include <atomic>
-#include <future>
-#include <boost/beast/core.hpp>
-#include <boost/beast/http.hpp>
-#include <boost/beast/version.hpp>
-#include <boost/beast/ssl.hpp>
-#include <boost/asio/connect.hpp>
-#include <boost/asio/ip/tcp.hpp>
-#include <boost/asio/ssl.hpp>
-#include <openssl/err.h>
-#include <libxml/parser.h>
-#include <zlib.h>
+#include <memory>
+#include <unordered_map>
 #include "config.h"
 #include "db.h"
+#include "bulk_loader.h"
+#include "checkpoint.h"
+#include "fetcher.h"
+#include "frontier.h"
+#include "scheduler.h"
+#include "url_set.h"
+#include "word_cache.h"
 #include "utils.h"
 
-namespace beast = boost::beast;
-namespace http = beast::http;
-namespace net = boost::asio;
-namespace ssl = net::ssl;
-using tcp = net::ip::tcp;
-
-class ThreadPool {
-public:
-    ThreadPool(size_t threads = std::thread::hardware_concurrency()) {
-        for (size_t i = 0; i < threads; ++i) {
-            workers.emplace_back([this] {
-                for (;;) {
-                    std::function<void()> task;
-                    {
-                        std::unique_lock<std::mutex> lock(queue_mutex);
-                        condition.wait(lock, [this] { return stop || !tasks.empty(); });
-                        if (stop && tasks.empty()) return;
-                        task = std::move(tasks.front());
-                        tasks.pop();
-                    }
-                    task();
-                }
-            });
-        }
-    }
-    
-    ~ThreadPool() {
-        {
-            std::unique_lock<std::mutex> lock(queue_mutex);
-            stop = true;
-        }
-        condition.notify_all();
-        for (auto& worker : workers) {
-            if (worker.joinable()) {
-                worker.join();
-            }
-        }
-    }
-    
-    template<class F>
-    void enqueue(F&& task) {
-        {
-            std::unique_lock<std::mutex> lock(queue_mutex);
-            if (stop) return;
-            tasks.emplace(std::forward<F>(task));
-        }
-        condition.notify_one();
-    }
-    
-private:
-    std::vector<std::thread> workers;
-    std::queue<std::function<void()>> tasks;
-    std::mutex queue_mutex;
-    std::condition_variable condition;
-    bool stop = false;
-};
-
-// Функция для распаковки gzip
-std::string decompress_gzip(const std::string& compressed) {
-    if (compressed.size() <= 4) return compressed;
-    
-    z_stream zs;
-    memset(&zs, 0, sizeof(zs));
-    
-    if (inflateInit2(&zs, 16 + MAX_WBITS) != Z_OK) {
-        return compressed;
-    }
-    
-    zs.next_in = (Bytef*)compressed.data();
-    zs.avail_in = (uInt)compressed.size();
-    
-    int ret;
-    char outbuffer[32768];
-    std::string outstring;
-    
-    do {
-        zs.next_out = reinterpret_cast<Bytef*>(outbuffer);
-        zs.avail_out = sizeof(outbuffer);
-        
-        ret = inflate(&zs, 0);
-        
-        if (outstring.size() < zs.total_out) {
-            outstring.append(outbuffer, zs.total_out - outstring.size());
-        }
-    } while (ret == Z_OK);
-    
-    inflateEnd(&zs);
-    
-    if (ret != Z_STREAM_END) {
-        std::cerr << "Gzip decompression error: " << ret << std::endl;
-        return compressed;
-    }
-    
-    return outstring;
-}
-
 // Получение домена из URL
 std::string get_domain(const std::string& url) {
     size_t start = url.find("://");
@@ -131,213 +30,190 @@ std::string get_domain(const std::string& url) {
     return url.substr(start, end - start);
 }
 
-std::string download_page(const std::string& url) {
+int main(int argc, char** argv) {
     try {
-        size_t pos = url.find("://");
-        if (pos == std::string::npos) {
-            throw std::runtime_error("Invalid URL: missing protocol");
+        bool resume = false;
+        for (int i = 1; i < argc; ++i) {
+            if (std::string(argv[i]) == "--resume") resume = true;
         }
         
-        std::string protocol = url.substr(0, pos);
-        std::string rest = url.substr(pos + 3);
+        auto config_map = parse_ini("config.ini");
+        Config cfg(config_map);
+        DatabasePool db_pool(cfg, cfg.db_pool_size);
+        db_pool.acquire()->create_tables();
         
-        size_t path_pos = rest.find('/');
-        std::string host = (path_pos == std::string::npos) ? rest : rest.substr(0, path_pos);
-        std::string target = (path_pos == std::string::npos) ? "/" : rest.substr(path_pos);
+        std::cout << "Starting spider with URL: " << cfg.start_page << std::endl;
+        std::cout << "Recursion depth: " << cfg.recursion_depth << std::endl;
+        std::cout << "Database connections: " << db_pool.size() << std::endl;
         
-        std::string port = (protocol == "https") ? "443" : "80";
+        WordCache word_cache;
+        if (cfg.word_cache) {
+            word_cache.warm(db_pool.acquire()->load_words());
+            db_pool.set_word_cache(&word_cache);
+            std::cout << "Word cache warmed with " << word_cache.size() << " words" << std::endl;
+        }
         
-        size_t colon_pos = host.find(':');
-        if (colon_pos != std::string::npos) {
-            port = host.substr(colon_pos + 1);
-            host = host.substr(0, colon_pos);
+        std::unique_ptr<BulkLoader> loader;
+        if (cfg.bulk_load) {
+            loader = std::make_unique<BulkLoader>(db_pool, cfg.bulk_batch_size,
+                                                  std::chrono::milliseconds(cfg.bulk_flush_interval_ms));
+            std::cout << "Bulk load mode: batch " << cfg.bulk_batch_size
+                      << " rows, flush every " << cfg.bulk_flush_interval_ms << " ms" << std::endl;
         }
         
-        net::io_context ioc;
+        size_t threads = cfg.spider_threads > 0 ? cfg.spider_threads : std::thread::hardware_concurrency();
+        Scheduler scheduler(threads);
+        std::cout << "Worker threads: " << scheduler.size() << std::endl;
         
-        http::request<http::string_body> req{http::verb::get, target, 11};
-        req.set(http::field::host, host);
-        req.set(http::field::user_agent, "Mozilla/5.0 (Windows NT 10.0; Win64; x64) AppleWebKit/537.36");
-        req.set(http::field::accept, "text/html,application/xhtml+xml,application/xml;q=0.9,*/*;q=0.8");
-        req.set(http::field::connection, "close");
+        // Ссылки приходят в канонической форме, поэтому /a, /a#x и /a/ - одна страница
+        UrlSet visited(static_cast<size_t>(cfg.url_bloom_mb) * 8 * 1024 * 1024);
+        std::set<std::string> domains_allowed;
         
-        if (protocol == "https") {
-            ssl::context ctx{ssl::context::tls_client};
-            ctx.set_default_verify_paths();
-            ctx.set_verify_mode(ssl::verify_none);
-            
-            beast::ssl_stream<beast::tcp_stream> stream(ioc, ctx);
-            
-            if (!SSL_set_tlsext_host_name(stream.native_handle(), host.c_str())) {
-                beast::error_code ec{static_cast<int>(::ERR_get_error()),
-                                    net::error::get_ssl_category()};
-                throw beast::system_error{ec};
+        // Очередь и просмотренные URL сохраняются на диск; с --resume обход
+        // продолжается с сохранённой очереди вместо стартовой страницы
+        std::unique_ptr<Checkpoint> checkpoint;
+        std::vector<Checkpoint::Pending> resumed;
+        if (!cfg.checkpoint_dir.empty()) {
+            checkpoint = std::make_unique<Checkpoint>(cfg.checkpoint_dir, visited, cfg.checkpoint_every);
+            resumed = checkpoint->open(resume);
+            if (resume) {
+                std::cout << "Resuming: " << visited.size() << " URLs already seen, "
+                          << resumed.size() << " queued" << std::endl;
             }
-            
-            tcp::resolver resolver(ioc);
-            auto const results = resolver.resolve(host, port);
-            
-            beast::get_lowest_layer(stream).expires_after(std::chrono::seconds(10));
-            
-            beast::get_lowest_layer(stream).connect(results);
-            stream.handshake(ssl::stream_base::client);
-            
-            http::write(stream, req);
-            
-            beast::flat_buffer buffer;
-            http::response<http::dynamic_body> res;
-            http::read(stream, buffer, res);
-            
-            std::string body = beast::buffers_to_string(res.body().data());
-            
-            auto encoding = res.find(http::field::content_encoding);
-            if (encoding != res.end()) {
-                std::string encoding_str = std::string(encoding->value());
-                if (encoding_str.find("gzip") != std::string::npos || 
-                    encoding_str.find("deflate") != std::string::npos) {
-                    body = decompress_gzip(body);
-                }
-            }
-            
-            beast::error_code ec;
-            stream.shutdown(ec);
-            
-            if (ec && ec != net::error::eof && 
-                ec != beast::errc::not_connected && 
-                !ec.message().empty()) {
-                std::cerr << "SSL shutdown warning: " << ec.message() << std::endl;
-            }
-            
-            return body;
-        } else {
-            tcp::resolver resolver(ioc);
-            auto const results = resolver.resolve(host, port);
-            
-            beast::tcp_stream stream(ioc);
-            stream.expires_after(std::chrono::seconds(10));
-            
-            stream.connect(results);
-            http::write(stream, req);
-            
-            beast::flat_buffer buffer;
-            http::response<http::dynamic_body> res;
-            http::read(stream, buffer, res);
-            
-            std::string body = beast::buffers_to_string(res.body().data());
-            
-            beast::error_code ec;
-            stream.socket().shutdown(tcp::socket::shutdown_both, ec);
-            
-            if (ec && ec != net::error::eof) {
-                std::cerr << "HTTP shutdown warning: " << ec.message() << std::endl;
-            }
-            
-            return body;
         }
-    } catch (const std::exception& e) {
-        std::cerr << "Download error for " << url << ": " << e.what() << std::endl;
-        return "";
-    }
-}
-
-int main(int argc, char** argv) {
-    try {
-        xmlInitParser();
         
-        auto config_map = parse_ini("config.ini");
-        Config cfg(config_map);
-        Database db(cfg);
-        db.create_tables();
-        
-        std::cout << "Starting spider with URL: " << cfg.start_page << std::endl;
-        std::cout << "Recursion depth: " << cfg.recursion_depth << std::endl;
-        
-        ThreadPool pool(2);
-        
-        std::set<std::string> visited;
-        std::mutex visited_mutex;
-        std::set<std::string> domains_allowed;
-        
-        std::string start_domain = get_domain(cfg.start_page);
+        std::string start_page = canonicalize_url(cfg.start_page);
+        std::string start_domain = get_domain(start_page);
         domains_allowed.insert(start_domain);
         std::cout << "Allowed domain: " << start_domain << std::endl;
         
         std::atomic<int> processed_count{0};
         std::atomic<int> error_count{0};
-        std::atomic<int> tasks_in_progress{0};
-        std::promise<void> all_done;
-        std::future<void> all_done_future = all_done.get_future();
+        
+        Fetcher fetcher(cfg);
+        std::cout << "Concurrent fetches: " << cfg.max_in_flight << std::endl;
+        
+        // Валидаторы и хеши содержимого с прошлых обходов; во время обхода только читаются
+        const std::unordered_map<std::string, DocumentMeta> known = db_pool.acquire()->load_documents();
+        std::cout << "Known documents: " << known.size() << std::endl;
+        std::atomic<int> unchanged_count{0};
         
         std::function<void(const std::string&, int)> process_url;
+        std::function<void(const FetchResult&, int)> process_page;
+        
+        // Очереди по хостам с ограничением частоты и robots.txt;
+        // загруженные страницы возвращаются в планировщик
+        Frontier frontier(cfg, fetcher, scheduler, [&](const FetchResult& page, int depth) {
+            process_page(page, depth);
+        });
+        std::cout << "Per-host limits: one request per " << cfg.host_delay_ms << " ms, burst " << cfg.host_burst
+                  << ", " << cfg.host_max_connections << " concurrent" << std::endl;
+        
+        // Условный запрос только для страниц последнего уровня: ответ 304 приходит
+        // без тела, а ссылки с более высоких уровней ещё нужно обойти
+        auto enqueue = [&](const std::string& url, int depth) {
+            Validators validators;
+            if (depth >= cfg.recursion_depth) {
+                auto it = known.find(url);
+                if (it != known.end()) validators = {it->second.etag, it->second.last_modified};
+            }
+            frontier.push(url, depth, std::move(validators));
+        };
+        
         process_url = [&](const std::string& url, int depth) {
-            tasks_in_progress++;
-            
-            auto task_cleanup = [&]() {
-                if (--tasks_in_progress == 0) {
-                    all_done.set_value();
-                }
-            };
-            
             if (depth > cfg.recursion_depth) {
-                task_cleanup();
                 return;
             }
             
-            {
-                std::lock_guard<std::mutex> lock(visited_mutex);
-                if (visited.count(url)) {
-                    task_cleanup();
-                    return;
-                }
-                visited.insert(url);
+            if (!visited.insert(url)) {
+                return;
             }
             
             std::string domain = get_domain(url);
             if (domains_allowed.count(domain) == 0) {
                 std::cout << "Skipping URL from different domain: " << url << std::endl;
-                task_cleanup();
                 return;
             }
             
+            std::cout << "Queued [" << depth << "]: " << url << std::endl;
+            if (checkpoint) checkpoint->queued(url, depth);
+            enqueue(url, depth);
+        };
+        
+        process_page = [&](const FetchResult& page, int depth) {
+            const std::string& url = page.url;
+            const std::string& html = page.body;
+            
+            // Страница отмечается завершённой, когда отработали и она, и задачи её ссылок:
+            // иначе ссылки, не дошедшие до очереди, потерялись бы при сбое
+            std::shared_ptr<void> page_done(nullptr, [&, url](void*) {
+                if (checkpoint) checkpoint->done(url);
+            });
+            
             try {
-                std::cout << "Processing [" << depth << "]: " << url << std::endl;
-                
-                std::string html = download_page(url);
-                
-                if (!html.empty() && html.size() > 100) {
-                    std::string text = remove_html_tags(html);
-                    std::string cleaned_text = clean_text(text);
-                    auto freq = count_word_frequency(cleaned_text);
+                if (!page.error.empty()) {
+                    error_count++;
+                    std::cerr << "Download error for " << url << ": " << page.error << std::endl;
+                } else if (page.status == 304) {
+                    unchanged_count++;
+                    std::cout << "Not modified: " << url << std::endl;
+                } else if (page.status >= 400) {
+                    error_count++;
+                    std::cerr << "HTTP " << page.status << " for " << url << std::endl;
+                } else if (!html.empty() && html.size() > 100) {
+                    DocumentMeta meta{page.etag, page.last_modified, static_cast<int64_t>(hash_content(html))};
+                    auto previous = known.find(url);
+                    bool unchanged = previous != known.end() && previous->second.content_hash == meta.content_hash;
+                    bool follow_links = depth < cfg.recursion_depth;
+                    
+                    // Неизменившаяся страница не индексируется заново; разбирается,
+                    // только если с неё нужно идти по ссылкам
+                    ParsedPage parsed;
+                    if (!unchanged || follow_links) parsed = parse_html(html, url);
                     
-                    if (!freq.empty()) {
-                        int doc_id = db.get_or_insert_doc(url);
-                        std::cout << "Saving " << freq.size() << " words for document " << doc_id << std::endl;
+                    if (unchanged) {
+                        unchanged_count++;
+                        std::cout << "Unchanged: " << url << std::endl;
+                    } else {
+                        // Буфер слов и счётчик переиспользуются потоком от страницы к странице
+                        thread_local std::string word_buffer;
+                        thread_local WordCounter freq;
+                        count_words(parsed.text, word_buffer, freq);
                         
-                        for (const auto& [word, count] : freq) {
-                            int word_id = db.get_or_insert_word(word);
-                            db.insert_frequency(word_id, doc_id, count);
+                        // Известный документ без слов тоже записывается, чтобы удалить старые слова
+                        if (!freq.empty() || previous != known.end()) {
+                            if (loader) {
+                                loader->add(url, freq, meta);
+                            } else {
+                                int doc_id = db_pool.acquire()->index_document(url, freq, meta);
+                                std::cout << "Saved " << freq.size() << " words for document " << doc_id << std::endl;
+                            }
+                            
+                            processed_count++;
+                            std::cout << "Processed " << processed_count << " pages. Words: " << freq.size() << std::endl;
+                        } else {
+                            std::cout << "No words found in " << url << std::endl;
                         }
-                        
-                        processed_count++;
-                        std::cout << "Processed " << processed_count << " pages. Words: " << freq.size() << std::endl;
-                    } else {
-                        std::cout << "No words found in " << url << std::endl;
                     }
                     
-                    if (depth < cfg.recursion_depth) {
-                        auto links = extract_links(html, url);
+                    if (follow_links) {
+                        const auto& links = parsed.links;
                         
                         if (!links.empty()) {
                             std::cout << "Found " << links.size() << " links on " << url << std::endl;
                             
-                            int link_limit = 5;
-                            for (const auto& link : links) {
-                                if (link_limit-- <= 0) break;
+                            size_t link_limit = cfg.max_links_per_page > 0 ? cfg.max_links_per_page : links.size();
+                            for (const auto& found : links) {
+                                if (link_limit-- == 0) break;
+                                
+                                std::string link = canonicalize_url(found);
+                                if (visited.contains(link)) continue;
                                 
                                 std::string link_domain = get_domain(link);
                                 if (domains_allowed.count(link_domain) > 0) {
-                                    pool.enqueue([=, &process_url] { 
-                                        process_url(link, depth + 1); 
+                                    scheduler.submit([=, &process_url] {
+                                        (void)page_done;
+                                        process_url(link, depth + 1);
                                     });
                                 }
                             }
@@ -351,26 +227,51 @@ int main(int argc, char** argv) {
                 error_count++;
                 std::cerr << "Error processing " << url << ": " << e.what() << std::endl;
             }
-            
-            task_cleanup();
         };
         
-        pool.enqueue([&] { 
-            process_url(cfg.start_page, 1); 
-        });
+        if (!resumed.empty()) {
+            for (const auto& entry : resumed) {
+                enqueue(entry.url, entry.depth);
+            }
+        } else {
+            scheduler.submit([&] {
+                process_url(start_page, 1);
+            });
+        }
         
-        all_done_future.wait();
+        scheduler.wait_idle();
+        frontier.stop();
+        fetcher.stop();
+        if (checkpoint) checkpoint->snapshot();
+        
+        if (loader) {
+            loader->finish();
+            std::cout << "Bulk loader: " << loader->rows_written() << " rows in "
+                      << loader->batches_written() << " batches, failed rows: " << loader->rows_failed() << std::endl;
+        }
         
         std::cout << "\n=== Spider finished ===" << std::endl;
         std::cout << "Total pages processed: " << processed_count << std::endl;
+        std::cout << "Unchanged pages skipped: " << unchanged_count << std::endl;
         std::cout << "Errors: " << error_count << std::endl;
-        std::cout << "Unique URLs visited: " << visited.size() << std::endl;
-        
-        xmlCleanupParser();
-        
+        std::cout << "Unique URLs visited: " << visited.size() << " (" << visited.memory_usage() / 1024
+                  << " KB in the seen set)" << std::endl;
+        std::cout << "Connections opened: " << fetcher.connections_opened()
+                  << ", reused: " << fetcher.connections_reused()
+                  << ", TLS sessions resumed: " << fetcher.tls_resumed() << std::endl;
+        std::cout << "Hosts: " << frontier.hosts() << ", URLs blocked by robots.txt: "
+                  << frontier.robots_blocked() << std::endl;
+        std::cout << "Tasks stolen between workers: " << scheduler.steals() << std::endl;
+        std::cout << "DNS cache: " << fetcher.dns().hits() << " hits, " << fetcher.dns().misses()
+                  << " misses, " << fetcher.dns().shared() << " shared lookups" << std::endl;
+        if (cfg.word_cache) {
+            size_t hits = word_cache.hits();
+            size_t lookups = hits + word_cache.misses();
+            std::cout << "Word cache: " << hits << " hits, " << word_cache.misses() << " misses, hit rate "
+                      << (lookups ? 100.0 * hits / lookups : 0.0) << "%" << std::endl;
+        }
     } catch (const std::exception& e) {
         std::cerr << "Fatal error: " << e.what() << std::endl;
-        xmlCleanupParser();
         return 1;
     }
     
@@ -0,0 +1,136 @@
+#include "url_set.h"
+
+namespace {
+
+const size_t initial_slots = 256;
+const int bloom_hashes = 4;
+
+uint64_t mix(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+} // namespace
+
+UrlSet::UrlSet(size_t bloom_bits, size_t shard_count)
+    : shard_count(shard_count > 0 ? shard_count : 1), shards(new Shard[this->shard_count]),
+      bloom_bits((bloom_bits + 63) / 64 * 64) {
+    for (size_t i = 0; i < this->shard_count; ++i) {
+        shards[i].slots.assign(initial_slots, 0);
+    }
+    if (this->bloom_bits > 0) {
+        size_t words = this->bloom_bits / 64;
+        bloom.reset(new std::atomic<uint64_t>[words]);
+        for (size_t i = 0; i < words; ++i) bloom[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+// FNV-1a с перемешиванием; 0 занят под пустой слот
+uint64_t UrlSet::fingerprint(std::string_view url) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (unsigned char c : url) hash = (hash ^ c) * 1099511628211ULL;
+    hash = mix(hash);
+    return hash ? hash : 1;
+}
+
+UrlSet::Shard& UrlSet::shard_for(uint64_t fp) const {
+    return shards[(fp >> 32) % shard_count];
+}
+
+bool UrlSet::find_slot(const Shard& shard, uint64_t fp, size_t& index) {
+    size_t mask = shard.slots.size() - 1;
+    for (index = fp & mask;; index = (index + 1) & mask) {
+        uint64_t slot = shard.slots[index];
+        if (slot == fp) return true;
+        if (slot == 0) return false;
+    }
+}
+
+void UrlSet::grow(Shard& shard) {
+    std::vector<uint64_t> old;
+    old.swap(shard.slots);
+    shard.slots.assign(old.size() * 2, 0);
+    for (uint64_t fp : old) {
+        if (fp == 0) continue;
+        size_t index;
+        find_slot(shard, fp, index);
+        shard.slots[index] = fp;
+    }
+}
+
+bool UrlSet::bloom_test(uint64_t fp) const {
+    uint64_t step = mix(fp) | 1;
+    for (int i = 0; i < bloom_hashes; ++i) {
+        uint64_t bit = (fp + i * step) % bloom_bits;
+        if (!(bloom[bit / 64].load(std::memory_order_relaxed) & (1ULL << (bit % 64)))) return false;
+    }
+    return true;
+}
+
+void UrlSet::bloom_set(uint64_t fp) {
+    uint64_t step = mix(fp) | 1;
+    for (int i = 0; i < bloom_hashes; ++i) {
+        uint64_t bit = (fp + i * step) % bloom_bits;
+        bloom[bit / 64].fetch_or(1ULL << (bit % 64), std::memory_order_relaxed);
+    }
+}
+
+bool UrlSet::insert(std::string_view url) {
+    return insert_fingerprint(fingerprint(url));
+}
+
+bool UrlSet::insert_fingerprint(uint64_t fp) {
+    Shard& shard = shard_for(fp);
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        size_t index;
+        if (find_slot(shard, fp, index)) return false;
+        shard.slots[index] = fp;
+        // Таблица заполняется не больше чем на 3/4
+        if (++shard.count * 4 > shard.slots.size() * 3) grow(shard);
+    }
+    if (bloom) bloom_set(fp);
+    return true;
+}
+
+bool UrlSet::contains(std::string_view url) const {
+    uint64_t fp = fingerprint(url);
+    if (bloom && !bloom_test(fp)) return false;
+    const Shard& shard = shard_for(fp);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    size_t index;
+    return find_slot(shard, fp, index);
+}
+
+std::vector<uint64_t> UrlSet::fingerprints() const {
+    std::vector<uint64_t> result;
+    for (size_t i = 0; i < shard_count; ++i) {
+        std::lock_guard<std::mutex> lock(shards[i].mutex);
+        for (uint64_t fp : shards[i].slots) {
+            if (fp != 0) result.push_back(fp);
+        }
+    }
+    return result;
+}
+
+size_t UrlSet::size() const {
+    size_t total = 0;
+    for (size_t i = 0; i < shard_count; ++i) {
+        std::lock_guard<std::mutex> lock(shards[i].mutex);
+        total += shards[i].count;
+    }
+    return total;
+}
+
+size_t UrlSet::memory_usage() const {
+    size_t total = bloom_bits / 8;
+    for (size_t i = 0; i < shard_count; ++i) {
+        std::lock_guard<std::mutex> lock(shards[i].mutex);
+        total += shards[i].slots.capacity() * sizeof(uint64_t);
+    }
+    return total;
+}
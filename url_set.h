@@ -0,0 +1,51 @@
+#ifndef URL_SET_H
+#define URL_SET_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+// Множество просмотренных URL. Вместо строк хранятся 64-битные отпечатки
+// в открытой адресации (8 байт на слот), таблица разбита на шарды со своим мьютексом.
+// Необязательный фильтр Блума отвечает на contains() для новых URL без блокировок
+class UrlSet {
+public:
+    explicit UrlSet(size_t bloom_bits = 0, size_t shard_count = 64);
+    
+    // true, если URL встретился впервые
+    bool insert(std::string_view url);
+    bool contains(std::string_view url) const;
+    
+    // Для сохранения и восстановления множества (Checkpoint)
+    bool insert_fingerprint(uint64_t fp);
+    std::vector<uint64_t> fingerprints() const;
+    
+    size_t size() const;
+    size_t memory_usage() const;
+    
+    static uint64_t fingerprint(std::string_view url);
+    
+private:
+    struct alignas(64) Shard {
+        mutable std::mutex mutex;
+        std::vector<uint64_t> slots;
+        size_t count = 0;
+    };
+    
+    Shard& shard_for(uint64_t fp) const;
+    static bool find_slot(const Shard& shard, uint64_t fp, size_t& index);
+    static void grow(Shard& shard);
+    bool bloom_test(uint64_t fp) const;
+    void bloom_set(uint64_t fp);
+    
+    size_t shard_count;
+    std::unique_ptr<Shard[]> shards;
+    size_t bloom_bits;
+    std::unique_ptr<std::atomic<uint64_t>[]> bloom;
+};
+
+#endif
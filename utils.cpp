@@ -1,107 +1,413 @@
 #include "utils.h"
 #include <algorithm>
 #include <cctype>
+#include <cstring>
 #include <sstream>
 #include <stdexcept>
-#include <libxml/HTMLparser.h>
-#include <libxml/xpath.h>
-#include <libxml/uri.h>
-#include <iostream>
 
-std::string remove_html_tags(const std::string& html) {
-    std::regex tag_regex("<[^>]*>");
-    return std::regex_replace(html, tag_regex, "");
+namespace {
+
+bool starts_with_nocase(const char* p, const char* end, const char* prefix) {
+    for (; *prefix; ++p, ++prefix) {
+        if (p == end || std::tolower(static_cast<unsigned char>(*p)) != *prefix) return false;
+    }
+    return true;
 }
 
-std::string clean_text(const std::string& text) {
-    std::string cleaned;
-    cleaned.reserve(text.size());
-    for (unsigned char c : text) {
-        if (std::isalnum(static_cast<unsigned char>(c)) || std::isspace(static_cast<unsigned char>(c))) {
-            cleaned += static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+const char* find_nocase(const char* p, const char* end, const char* needle) {
+    size_t n = std::strlen(needle);
+    for (; p + n <= end; ++p) {
+        if (starts_with_nocase(p, end, needle)) return p;
+    }
+    return end;
+}
+
+void append_utf8(std::string& out, unsigned long code) {
+    if (code == 0 || code > 0x10FFFF || (code >= 0xD800 && code <= 0xDFFF)) code = 0xFFFD;
+    if (code < 0x80) {
+        out += static_cast<char>(code);
+    } else if (code < 0x800) {
+        out += static_cast<char>(0xC0 | (code >> 6));
+        out += static_cast<char>(0x80 | (code & 0x3F));
+    } else if (code < 0x10000) {
+        out += static_cast<char>(0xE0 | (code >> 12));
+        out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (code & 0x3F));
+    } else {
+        out += static_cast<char>(0xF0 | (code >> 18));
+        out += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+        out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (code & 0x3F));
+    }
+}
+
+struct NamedEntity {
+    const char* name;
+    const char* value;
+};
+
+const NamedEntity named_entities[] = {
+    {"amp", "&"}, {"lt", "<"}, {"gt", ">"}, {"quot", "\""}, {"apos", "'"},
+    {"nbsp", " "}, {"shy", ""}, {"copy", "\xC2\xA9"}, {"reg", "\xC2\xAE"},
+    {"laquo", "\xC2\xAB"}, {"raquo", "\xC2\xBB"}, {"ndash", "\xE2\x80\x93"},
+    {"mdash", "\xE2\x80\x94"}, {"hellip", "\xE2\x80\xA6"}, {"lsquo", "\xE2\x80\x98"},
+    {"rsquo", "\xE2\x80\x99"}, {"ldquo", "\xE2\x80\x9C"}, {"rdquo", "\xE2\x80\x9D"},
+    {"bull", "\xE2\x80\xA2"}, {"middot", "\xC2\xB7"}, {"times", "\xC3\x97"},
+};
+
+// Разбирает сущность, начинающуюся с '&' в p. Возвращает указатель за ней
+// или p, если это не сущность (тогда '&' выводится как есть)
+const char* decode_entity(const char* p, const char* end, std::string& out) {
+    const char* q = p + 1;
+    if (q < end && *q == '#') {
+        ++q;
+        bool hex = q < end && (*q == 'x' || *q == 'X');
+        if (hex) ++q;
+        unsigned long code = 0;
+        const char* digits = q;
+        while (q < end && q - digits < 8 &&
+               (hex ? std::isxdigit(static_cast<unsigned char>(*q)) : std::isdigit(static_cast<unsigned char>(*q)))) {
+            char c = static_cast<char>(std::tolower(static_cast<unsigned char>(*q)));
+            code = code * (hex ? 16 : 10) + (c >= 'a' ? c - 'a' + 10 : c - '0');
+            ++q;
+        }
+        if (q == digits) return p;
+        if (q < end && *q == ';') ++q;
+        append_utf8(out, code);
+        return q;
+    }
+    
+    const char* name = q;
+    while (q < end && q - name < 8 && std::isalnum(static_cast<unsigned char>(*q))) ++q;
+    size_t length = q - name;
+    for (const auto& entity : named_entities) {
+        if (std::strlen(entity.name) == length && std::memcmp(entity.name, name, length) == 0) {
+            if (q < end && *q == ';') ++q;
+            out += entity.value;
+            return q;
+        }
+    }
+    return p;
+}
+
+void append_decoded(std::string& out, const char* p, const char* end) {
+    while (p < end) {
+        if (*p == '&') {
+            const char* next = decode_entity(p, end, out);
+            if (next != p) {
+                p = next;
+                continue;
+            }
+        }
+        out += *p++;
+    }
+}
+
+void append_space(std::string& text) {
+    if (!text.empty() && text.back() != ' ') text += ' ';
+}
+
+std::string resolve_link(std::string link, const std::string& base_url) {
+    if (link.find("://") == std::string::npos) {
+        if (link[0] == '/') {
+            size_t protocol_end = base_url.find("://");
+            if (protocol_end != std::string::npos) {
+                std::string domain = base_url.substr(0, base_url.find('/', protocol_end + 3));
+                link = domain + link;
+            } else {
+                link = base_url + link;
+            }
+        } else {
+            std::string base = base_url;
+            if (base.empty() || base.back() != '/') base += '/';
+            link = base + link;
+        }
+    }
+    return link;
+}
+
+void add_link(ParsedPage& page, std::string link, const std::string& base_url) {
+    size_t first = link.find_first_not_of(" \t\r\n");
+    size_t last = link.find_last_not_of(" \t\r\n");
+    if (first == std::string::npos) return;
+    link = link.substr(first, last - first + 1);
+    
+    if (link[0] == '#' ||
+        link.find("javascript:") == 0 ||
+        link.find("mailto:") == 0 ||
+        link.find("tel:") == 0) {
+        return;
+    }
+    
+    link = resolve_link(std::move(link), base_url);
+    if (link.find("http://") == 0 || link.find("https://") == 0) {
+        page.links.push_back(std::move(link));
+    }
+}
+
+} // namespace
+
+// Однопроходный разбор HTML: видимый текст без тегов, комментариев и
+// содержимого script/style с раскрытыми сущностями, плюс href всех ссылок
+ParsedPage parse_html(const std::string& html, const std::string& base_url) {
+    ParsedPage page;
+    page.text.reserve(html.size());
+    const char* p = html.data();
+    const char* end = p + html.size();
+    
+    while (p < end) {
+        const char* lt = static_cast<const char*>(std::memchr(p, '<', end - p));
+        const char* text_end = lt ? lt : end;
+        append_decoded(page.text, p, text_end);
+        if (!lt) break;
+        p = lt;
+        
+        if (starts_with_nocase(p, end, "<!--")) {
+            const char* close = std::search(p + 4, end, "-->", "-->" + 3);
+            p = close == end ? end : close + 3;
+            append_space(page.text);
+            continue;
+        }
+        
+        bool closing = p + 1 < end && p[1] == '/';
+        const char* q = p + (closing ? 2 : 1);
+        if (q >= end || !(std::isalpha(static_cast<unsigned char>(*q)) || (!closing && (*q == '!' || *q == '?')))) {
+            page.text += *p++;
+            continue;
+        }
+        
+        char name[16];
+        size_t name_length = 0;
+        while (q < end && (std::isalnum(static_cast<unsigned char>(*q)) || *q == '-' || *q == ':' || *q == '!' || *q == '?')) {
+            if (name_length < sizeof(name) - 1) {
+                name[name_length++] = static_cast<char>(std::tolower(static_cast<unsigned char>(*q)));
+            }
+            ++q;
+        }
+        name[name_length] = '\0';
+        bool is_link = !closing && std::strcmp(name, "a") == 0;
+        bool self_closing = false;
+        
+        // Атрибуты: значения в кавычках могут содержать '>'
+        while (q < end && *q != '>') {
+            if (*q == '/' && q + 1 < end && q[1] == '>') {
+                self_closing = true;
+                ++q;
+                break;
+            }
+            if (std::isspace(static_cast<unsigned char>(*q)) || *q == '/') {
+                ++q;
+                continue;
+            }
+            const char* attr = q;
+            while (q < end && *q != '=' && *q != '>' && !std::isspace(static_cast<unsigned char>(*q)) &&
+                   !(*q == '/' && q + 1 < end && q[1] == '>')) {
+                ++q;
+            }
+            size_t attr_length = q - attr;
+            while (q < end && std::isspace(static_cast<unsigned char>(*q))) ++q;
+            if (q >= end || *q != '=') continue;
+            ++q;
+            while (q < end && std::isspace(static_cast<unsigned char>(*q))) ++q;
+            
+            const char* value = q;
+            const char* value_end;
+            if (q < end && (*q == '"' || *q == '\'')) {
+                char quote = *q++;
+                value = q;
+                while (q < end && *q != quote) ++q;
+                value_end = q;
+                if (q < end) ++q;
+            } else {
+                while (q < end && *q != '>' && !std::isspace(static_cast<unsigned char>(*q))) ++q;
+                value_end = q;
+            }
+            
+            if (is_link && attr_length == 4 && starts_with_nocase(attr, end, "href")) {
+                std::string href;
+                append_decoded(href, value, value_end);
+                add_link(page, std::move(href), base_url);
+            }
+        }
+        p = q < end ? q + 1 : end;
+        append_space(page.text);
+        
+        if (!closing && !self_closing && (std::strcmp(name, "script") == 0 || std::strcmp(name, "style") == 0)) {
+            const char* close = find_nocase(p, end, std::strcmp(name, "script") == 0 ? "</script" : "</style");
+            p = close;
         }
     }
+    
+    return page;
+}
+
+std::string remove_html_tags(const std::string& html) {
+    return parse_html(html, "").text;
+}
+
+std::string clean_text(const std::string& text) {
+    std::string cleaned(text.size(), '\0');
+    cleaned.resize(normalize_text(text.data(), text.size(), &cleaned[0]));
     return cleaned;
 }
 
 std::map<std::string, int> count_word_frequency(const std::string& text) {
+    std::string buffer;
+    WordCounter counter;
+    count_words(text, buffer, counter);
     std::map<std::string, int> freq;
-    std::stringstream ss(text);
-    std::string word;
-    while (ss >> word) {
-        if (word.length() >= 3 && word.length() <= 32) {
-            freq[word]++;
-        }
+    for (const auto& entry : counter) {
+        freq.emplace(entry.word, entry.count);
     }
     return freq;
 }
 
-std::vector<std::string> extract_links(const std::string& html, const std::string& base_url) {
-    std::vector<std::string> urls;
-    
-    if (html.empty()) return urls;
-    
-    htmlDocPtr doc = htmlReadMemory(html.c_str(), (int)html.size(), base_url.c_str(), "UTF-8",
-                                    HTML_PARSE_RECOVER | HTML_PARSE_NOERROR | 
-                                    HTML_PARSE_NOWARNING | HTML_PARSE_NONET);
+namespace {
+
+const uint64_t fnv_offset = 14695981039346656037ULL;
+const uint64_t fnv_prime = 1099511628211ULL;
+
+inline bool is_word_boundary(unsigned char c) {
+    return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+} // namespace
+
+void WordCounter::clear() {
+    entries.clear();
+    std::fill(slots.begin(), slots.end(), 0);
+}
+
+void WordCounter::grow() {
+    size_t capacity = slots.empty() ? 256 : slots.size() * 2;
+    slots.assign(capacity, 0);
+    size_t mask = capacity - 1;
+    for (size_t n = 0; n < entries.size(); ++n) {
+        size_t i = entries[n].hash & mask;
+        while (slots[i] != 0) i = (i + 1) & mask;
+        slots[i] = static_cast<uint32_t>(n + 1);
+    }
+}
+
+bool WordCounter::add(std::string_view word, uint64_t hash) {
+    if ((entries.size() + 1) * 2 > slots.size()) grow();
+    size_t mask = slots.size() - 1;
+    for (size_t i = hash & mask;; i = (i + 1) & mask) {
+        uint32_t slot = slots[i];
+        if (slot == 0) {
+            entries.push_back({word, 1, hash});
+            slots[i] = static_cast<uint32_t>(entries.size());
+            return true;
+        }
+        Entry& entry = entries[slot - 1];
+        if (entry.hash == hash && entry.word == word) {
+            entry.count++;
+            return false;
+        }
+    }
+}
+
+// 64-битный FNV-1a: отпечаток тела страницы для повторного обхода
+uint64_t hash_content(std::string_view data) {
+    uint64_t hash = fnv_offset;
+    for (unsigned char c : data) hash = (hash ^ c) * fnv_prime;
+    return hash;
+}
+
+bool WordCounter::add(std::string_view word) {
+    uint64_t hash = fnv_offset;
+    for (unsigned char c : word) hash = (hash ^ c) * fnv_prime;
+    return add(word, hash);
+}
+
+// Нормализация текста в buffer (та же, что в clean_text для запросов), затем
+// разбиение на слова, фильтр длины 3-32 символа и подсчёт. Ключи счётчика
+// указывают в buffer
+void count_words(std::string_view text, std::string& buffer, WordCounter& counter) {
+    counter.clear();
+    buffer.resize(text.size());
+    size_t length = normalize_text(text.data(), text.size(), &buffer[0]);
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(buffer.data());
+    const unsigned char* end = p + length;
     
-    if (!doc) {
-        std::cerr << "Failed to parse HTML" << std::endl;
-        return urls;
+    while (p < end) {
+        while (p < end && is_word_boundary(*p)) ++p;
+        const unsigned char* word_start = p;
+        uint64_t hash = fnv_offset;
+        size_t chars = 0;
+        for (; p < end && !is_word_boundary(*p); ++p) {
+            hash = (hash ^ *p) * fnv_prime;
+            chars += (*p & 0xC0) != 0x80;
+        }
+        if (chars >= 3 && chars <= 32) {
+            counter.add(std::string_view(reinterpret_cast<const char*>(word_start), p - word_start), hash);
+        }
+    }
+}
+
+std::vector<std::string> extract_links(const std::string& html, const std::string& base_url) {
+    return parse_html(html, base_url).links;
+}
+
+namespace {
+
+// Удаление сегментов ".", ".." и пустых, в том числе завершающего после '/'
+std::string remove_dot_segments(const std::string& path) {
+    std::vector<std::string> segments;
+    size_t pos = 0;
+    while (pos <= path.size()) {
+        size_t end = path.find('/', pos);
+        if (end == std::string::npos) end = path.size();
+        std::string segment = path.substr(pos, end - pos);
+        if (segment == "..") {
+            if (!segments.empty()) segments.pop_back();
+        } else if (!segment.empty() && segment != ".") {
+            segments.push_back(std::move(segment));
+        }
+        pos = end + 1;
     }
     
-    xmlXPathContextPtr context = xmlXPathNewContext(doc);
-    if (!context) {
-        xmlFreeDoc(doc);
-        return urls;
+    std::string result;
+    for (const auto& segment : segments) {
+        result += '/';
+        result += segment;
     }
+    return result.empty() ? "/" : result;
+}
+
+} // namespace
+
+// Каноническая форма URL для дедупликации: схема и хост в нижнем регистре,
+// без фрагмента, порта по умолчанию, сегментов "."/".." и завершающего '/'
+std::string canonicalize_url(const std::string& url) {
+    size_t scheme_end = url.find("://");
+    if (scheme_end == std::string::npos) return url;
     
-    xmlXPathObjectPtr result = xmlXPathEvalExpression((const xmlChar*)"//a/@href", context);
+    std::string scheme = url.substr(0, scheme_end);
+    for (char& c : scheme) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
     
-    if (result && result->nodesetval) {
-        xmlNodeSetPtr nodes = result->nodesetval;
-        
-        for (int i = 0; i < nodes->nodeNr; ++i) {
-            xmlNodePtr node = nodes->nodeTab[i];
-            xmlChar* href = xmlNodeGetContent(node);
-            
-            if (href) {
-                std::string link((char*)href);
-                xmlFree(href);
-                
-                if (link.empty() || link[0] == '#' || 
-                    link.find("javascript:") == 0 || 
-                    link.find("mailto:") == 0 ||
-                    link.find("tel:") == 0) {
-                    continue;
-                }
-                
-                if (link.find("://") == std::string::npos) {
-                    if (link[0] == '/') {
-                        size_t protocol_end = base_url.find("://");
-                        if (protocol_end != std::string::npos) {
-                            std::string domain = base_url.substr(0, base_url.find('/', protocol_end + 3));
-                            link = domain + link;
-                        } else {
-                            link = base_url + link;
-                        }
-                    } else {
-                        std::string base = base_url;
-                        if (base.back() != '/') base += '/';
-                        link = base + link;
-                    }
-                }
-                
-                if (link.find("http://") == 0 || link.find("https://") == 0) {
-                    urls.push_back(link);
-                }
-            }
+    size_t host_start = scheme_end + 3;
+    size_t host_end = url.find_first_of("/?#", host_start);
+    if (host_end == std::string::npos) host_end = url.size();
+    std::string host = url.substr(host_start, host_end - host_start);
+    for (char& c : host) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    
+    size_t colon = host.rfind(':');
+    if (colon != std::string::npos && host.find(']', colon) == std::string::npos) {
+        std::string port = host.substr(colon + 1);
+        if (port.empty() || (scheme == "http" && port == "80") || (scheme == "https" && port == "443")) {
+            host.erase(colon);
         }
-        xmlXPathFreeObject(result);
     }
     
-    xmlXPathFreeContext(context);
-    xmlFreeDoc(doc);
+    size_t fragment = url.find('#', host_end);
+    if (fragment == std::string::npos) fragment = url.size();
+    size_t query = url.find('?', host_end);
+    if (query > fragment) query = fragment;
+    
+    std::string path = remove_dot_segments(url.substr(host_end, query - host_end));
     
-    return urls;
+    std::string result = scheme + "://" + host + path;
+    if (fragment - query > 1) result.append(url, query, fragment - query);
+    return result;
 }
\ No newline at end of file
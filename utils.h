@@ -1,15 +1,58 @@
 #ifndef UTILS_H
 #define UTILS_H
 
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <map>
 #include <vector>
-#include <regex>
 
+struct ParsedPage {
+    std::string text;
+    std::vector<std::string> links;
+};
+
+// Частоты слов страницы в хеш-таблице с открытой адресацией. Ключи - string_view
+// в буфер, заполненный count_words, поэтому буфер должен жить дольше счётчика.
+// clear() сохраняет выделенную память, так что один счётчик на поток
+// обходится без аллокаций на каждой странице
+class WordCounter {
+public:
+    struct Entry {
+        std::string_view word;
+        int count;
+        uint64_t hash;
+    };
+    
+    void clear();
+    bool add(std::string_view word, uint64_t hash);
+    bool add(std::string_view word);
+    
+    size_t size() const { return entries.size(); }
+    bool empty() const { return entries.empty(); }
+    std::vector<Entry>::const_iterator begin() const { return entries.begin(); }
+    std::vector<Entry>::const_iterator end() const { return entries.end(); }
+    
+private:
+    void grow();
+    
+    std::vector<Entry> entries;
+    std::vector<uint32_t> slots;
+};
+
+// Нормализация текста для индекса и запросов: нижний регистр (ASCII, латиница,
+// греческий, кириллица), цифры и буквы сохраняются, пунктуация выбрасывается,
+// пробелы Unicode становятся ' '. output должен вмещать size байт, возвращается длина
+size_t normalize_text(const char* input, size_t size, char* output);
+
+ParsedPage parse_html(const std::string& html, const std::string& base_url);
 std::string remove_html_tags(const std::string& html);
 std::string clean_text(const std::string& text);
 std::map<std::string, int> count_word_frequency(const std::string& text);
+void count_words(std::string_view text, std::string& buffer, WordCounter& counter);
+uint64_t hash_content(std::string_view data);
 std::vector<std::string> extract_links(const std::string& html, const std::string& base_url);
+std::string canonicalize_url(const std::string& url);
 std::string get_base_url(const std::string& url);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,61 @@
+#include "word_cache.h"
+#include <functional>
+#include <mutex>
+
+WordCache::WordCache(size_t shard_count)
+    : shard_count(shard_count > 0 ? shard_count : 1), shards(new Shard[this->shard_count]) {}
+
+WordCache::Shard& WordCache::shard_for(std::string_view word) const {
+    return shards[std::hash<std::string_view>{}(word) % shard_count];
+}
+
+bool WordCache::find(std::string_view word, int& id) const {
+    Shard& shard = shard_for(word);
+    {
+        std::shared_lock<std::shared_mutex> lock(shard.mutex);
+        auto it = shard.ids.find(word);
+        if (it != shard.ids.end()) {
+            id = it->second;
+            shard.hits.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    shard.misses.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+void WordCache::insert(std::string_view word, int id) {
+    Shard& shard = shard_for(word);
+    std::unique_lock<std::shared_mutex> lock(shard.mutex);
+    if (shard.ids.count(word)) return;
+    // Ключи map ссылаются на строки в deque, адреса которых не меняются при росте
+    const std::string& key = shard.storage.emplace_back(word);
+    shard.ids.emplace(key, id);
+}
+
+void WordCache::warm(const std::vector<std::pair<std::string, int>>& words) {
+    for (const auto& [word, id] : words) {
+        insert(word, id);
+    }
+}
+
+size_t WordCache::size() const {
+    size_t total = 0;
+    for (size_t i = 0; i < shard_count; ++i) {
+        std::shared_lock<std::shared_mutex> lock(shards[i].mutex);
+        total += shards[i].ids.size();
+    }
+    return total;
+}
+
+size_t WordCache::hits() const {
+    size_t total = 0;
+    for (size_t i = 0; i < shard_count; ++i) total += shards[i].hits.load(std::memory_order_relaxed);
+    return total;
+}
+
+size_t WordCache::misses() const {
+    size_t total = 0;
+    for (size_t i = 0; i < shard_count; ++i) total += shards[i].misses.load(std::memory_order_relaxed);
+    return total;
+}
@@ -0,0 +1,44 @@
+#ifndef WORD_CACHE_H
+#define WORD_CACHE_H
+
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Кэш word -> id, общий для всех потоков паука. Разбит на шарды с
+// shared_mutex: чтения идут параллельно, запись блокирует только свой шард.
+class WordCache {
+public:
+    explicit WordCache(size_t shard_count = 64);
+    
+    bool find(std::string_view word, int& id) const;
+    void insert(std::string_view word, int id);
+    void warm(const std::vector<std::pair<std::string, int>>& words);
+    
+    size_t size() const;
+    size_t hits() const;
+    size_t misses() const;
+    
+private:
+    struct alignas(64) Shard {
+        mutable std::shared_mutex mutex;
+        std::unordered_map<std::string_view, int> ids;
+        std::deque<std::string> storage;
+        mutable std::atomic<size_t> hits{0};
+        mutable std::atomic<size_t> misses{0};
+    };
+    
+    Shard& shard_for(std::string_view word) const;
+    
+    size_t shard_count;
+    std::unique_ptr<Shard[]> shards;
+};
+
+#endif